@@ -20,18 +20,35 @@
 #include <asm/unaligned.h>
 #endif
 
+#include <linux/bitops.h>
 #include <linux/crc16.h>
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/hid.h>
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
+#include <linux/iio/buffer.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/kfifo_buf.h>
 #include <linux/jiffies.h>
 #include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/rwsem.h>
 #include <linux/seq_file.h>
+#include <linux/seqlock.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
 #include <linux/usb.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <net/genetlink.h>
+
+#define CREATE_TRACE_POINTS
+#include "aquacomputer_d5next_trace.h"
 
 #define USB_VENDOR_ID_AQUACOMPUTER	0x0c70
 #define USB_PRODUCT_ID_AQUAERO		0xf001
@@ -55,31 +72,54 @@ enum kinds {
 
 enum aquaero_hw_kinds { unknown, aquaero5, aquaero6 };
 
-static const char *const aqc_device_names[] = {
-	[aquaero] = "aquaero",
-	[d5next] = "d5next",
-	[farbwerk] = "farbwerk",
-	[farbwerk360] = "farbwerk360",
-	[octo] = "octo",
-	[quadro] = "quadro",
-	[highflownext] = "highflownext",
-	[leakshield] = "leakshield",
-	[aquastreamxt] = "aquastreamxt",
-	[aquastreamult] = "aquastreamultimate",
-	[poweradjust3] = "poweradjust3",
-	[highflow] = "highflow"	/* Covers MPS Flow devices */
-};
-
 #define DRIVER_NAME			"aquacomputer_d5next"
 
 #define STATUS_REPORT_ID		0x01
 #define STATUS_UPDATE_INTERVAL		(2 * HZ)	/* In seconds */
+#define POLL_INTERVAL_DEFAULT		2000	/* ms */
+#define PUSH_REPORT_INTERVAL		1000	/* ms */
+#define UPDATE_INTERVAL_MIN		100	/* ms */
+#define UPDATE_INTERVAL_MAX		60000	/* ms */
 #define SERIAL_PART_OFFSET		2
 
 #define CTRL_REPORT_ID			0x03
 #define AQUAERO_CTRL_REPORT_ID		0x0b
 
 #define CTRL_REPORT_DELAY		200	/* ms */
+#define CTRL_REPORT_DELAY_MIN		50	/* ms, default floor of the adaptive delay */
+#define CTRL_REPORT_DELAY_MAX		2000	/* ms */
+#define CTRL_REPORT_DELAY_STEP		10	/* ms, least backoff */
+#define CTRL_REPORT_CACHE_TIME		1000	/* ms */
+#define CTRL_WRITE_DELAY_MAX		10000	/* ms */
+#define CTRL_COMMIT_INTERVAL_MAX	3600000	/* ms */
+
+#define RAW_HISTORY_MAX			4096	/* Reports */
+#define RAW_REPORT_DATA_SIZE		0x7f0
+
+/* Raw sensor report, as kept in history and read from debugfs */
+struct aqc_raw_record {
+	u64 timestamp;		/* In ns, from ktime_get_ns() */
+	u32 seq;		/* Count of reports received before this one */
+	u16 size;		/* Size of the report, data is truncated to RAW_REPORT_DATA_SIZE */
+	u8 report_id;
+	u8 reserved;
+	u8 data[RAW_REPORT_DATA_SIZE];
+};
+
+static unsigned int poll_interval = POLL_INTERVAL_DEFAULT;
+module_param(poll_interval, uint, 0444);
+MODULE_PARM_DESC(poll_interval,
+		 "Default interval for reading sensors of legacy devices, in ms (100 - 60000)");
+
+static unsigned int ctrl_cache_time = CTRL_REPORT_CACHE_TIME;
+module_param(ctrl_cache_time, uint, 0644);
+MODULE_PARM_DESC(ctrl_cache_time,
+		 "For how long a read control report is served from memory, in ms (0 to always re-read)");
+
+static unsigned int raw_history;
+module_param(raw_history, uint, 0444);
+MODULE_PARM_DESC(raw_history,
+		 "Count of raw sensor reports kept per device for debugfs (0 - disabled, max 4096)");
 
 /*
  * The HID report that the official software always sends
@@ -129,6 +169,7 @@ static u8 aquastreamxt_secondary_ctrl_report[] = {
 #define AQC_FIRMWARE_VERSION		0x0D
 #define AQC_POWER_CYCLES		0x18
 
+#define AQC_CHECKSUM_START		0x01	/* Checksum covers the report up to itself */
 #define AQC_SENSOR_SIZE			0x02
 #define AQC_SENSOR_NA			0x7FFF
 #define AQC_FAN_PERCENT_OFFSET		0x00
@@ -136,6 +177,7 @@ static u8 aquastreamxt_secondary_ctrl_report[] = {
 #define AQC_FAN_CURRENT_OFFSET		0x04
 #define AQC_FAN_POWER_OFFSET		0x06
 #define AQC_FAN_SPEED_OFFSET		0x08
+#define AQC_FAN_STRUCT_SIZE		0x0D
 #define AQC_FAN_CTRL_CURVE_NUM_POINTS	16
 
 /* Report offsets for fan control */
@@ -173,7 +215,8 @@ static u8 aquastreamxt_secondary_ctrl_report[] = {
 #define AQUAERO_FAN_CURRENT_OFFSET		0x06
 #define AQUAERO_FAN_POWER_OFFSET		0x08
 #define AQUAERO_FAN_SPEED_OFFSET		0x00
-static u16 aquaero_sensor_fan_offsets[] = { 0x167, 0x173, 0x17f, 0x18B };
+#define AQUAERO_FAN_SENSORS_START		0x167
+#define AQUAERO_FAN_STRUCT_SIZE			0x0C
 #define AQUAERO_CURRENT_UPTIME_OFFSET		0x11
 #define AQUAERO_TOTAL_UPTIME_OFFSET		0x15
 
@@ -185,7 +228,7 @@ static u16 aquaero_sensor_fan_offsets[] = { 0x167, 0x173, 0x17f, 0x18B };
 #define AQUAERO_FAN_CTRL_MAX_PWR_OFFSET	0x06
 #define AQUAERO_FAN_CTRL_MODE_OFFSET	0x0f
 #define AQUAERO_FAN_CTRL_SRC_OFFSET	0x10
-static u16 aquaero_ctrl_fan_offsets[] = { 0x20c, 0x220, 0x234, 0x248 };
+static const u16 aquaero_ctrl_fan_offsets[] = { 0x20c, 0x220, 0x234, 0x248 };
 
 /* Specs of the D5 Next pump */
 #define D5NEXT_NUM_FANS			2
@@ -200,19 +243,19 @@ static u16 aquaero_ctrl_fan_offsets[] = { 0x20c, 0x220, 0x234, 0x248 };
 #define D5NEXT_5V_VOLTAGE		0x39
 #define D5NEXT_12V_VOLTAGE		0x37
 #define D5NEXT_VIRTUAL_SENSORS_START	0x3f
-static u16 d5next_sensor_fan_offsets[] = { D5NEXT_PUMP_OFFSET, D5NEXT_FAN_OFFSET };
 
 /* Control report offsets for the D5 Next pump */
 #define D5NEXT_TEMP_CTRL_OFFSET		0x2D	/* Temperature sensor offsets location */
-static u16 d5next_ctrl_fan_offsets[] = { 0x96, 0x41 };	/* Pump and fan speed (from 0-100%) */
+/* Pump and fan speed (from 0-100%) */
+static const u16 d5next_ctrl_fan_offsets[] = { 0x96, 0x41 };
 /* Fan curve "hold min power" and "start boost" offsets, only for the fan, first value is unused */
-static u8 d5next_ctrl_fan_curve_hold_start_offsets[] = { 0x00, 0x2F };
+static const u8 d5next_ctrl_fan_curve_hold_start_offsets[] = { 0x00, 0x2F };
 /* Fan curve min power */
-static u8 d5next_ctrl_fan_curve_min_power_offsets[] = { 0x39, 0x30 };
+static const u8 d5next_ctrl_fan_curve_min_power_offsets[] = { 0x39, 0x30 };
 /* Fan curve max power */
-static u8 d5next_ctrl_fan_curve_max_power_offsets[] = { 0x3B, 0x32 };
+static const u8 d5next_ctrl_fan_curve_max_power_offsets[] = { 0x3B, 0x32 };
 /* Fan curve fallback power */
-static u8 d5next_ctrl_fan_curve_fallback_power_offsets[] = { 0x3D, 0x34 };
+static const u8 d5next_ctrl_fan_curve_fallback_power_offsets[] = { 0x3D, 0x34 };
 
 /* Specs of the Aquastream Ultimate pump */
 /* Pump does not follow the standard structure, so only consider the fan */
@@ -232,7 +275,6 @@ static u8 d5next_ctrl_fan_curve_fallback_power_offsets[] = { 0x3D, 0x34 };
 #define AQUASTREAMULT_FAN_CURRENT_OFFSET	0x00
 #define AQUASTREAMULT_FAN_POWER_OFFSET		0x04
 #define AQUASTREAMULT_FAN_SPEED_OFFSET		0x06
-static u16 aquastreamult_sensor_fan_offsets[] = { AQUASTREAMULT_FAN_OFFSET };
 
 /* Spec and sensor report offset for the Farbwerk RGB controller */
 #define FARBWERK_NUM_SENSORS		4
@@ -261,28 +303,28 @@ static u16 aquastreamult_sensor_fan_offsets[] = { AQUASTREAMULT_FAN_OFFSET };
 #define OCTO_SENSOR_START		0x3D
 #define OCTO_VIRTUAL_SENSORS_START	0x45
 #define OCTO_FLOW_SENSOR_OFFSET		0x7B
-static u16 octo_sensor_fan_offsets[] = { 0x7D, 0x8A, 0x97, 0xA4, 0xB1, 0xBE, 0xCB, 0xD8 };
+#define OCTO_FAN_SENSORS_START		0x7D
 
 /* Control report offsets for the Octo */
 #define OCTO_TEMP_CTRL_OFFSET		0xA
 #define OCTO_FLOW_PULSES_CTRL_OFFSET	0x6
 /* Fan speed offsets (0-100%) */
-static u16 octo_ctrl_fan_offsets[] = { 0x5A, 0xAF, 0x104, 0x159, 0x1AE, 0x203, 0x258, 0x2AD };
+static const u16 octo_ctrl_fan_offsets[] = { 0x5A, 0xAF, 0x104, 0x159, 0x1AE, 0x203, 0x258, 0x2AD };
 
 /* Fan curve "hold min power" and "start boost" offsets */
-static u8 octo_ctrl_fan_curve_hold_start_offsets[] = {
+static const u8 octo_ctrl_fan_curve_hold_start_offsets[] = {
 	0x12, 0x1B, 0x24, 0x2D, 0x36, 0x3F, 0x48, 0x51
 };
 
-static u8 octo_ctrl_fan_curve_min_power_offsets[] = {
+static const u8 octo_ctrl_fan_curve_min_power_offsets[] = {
 	0x13, 0x1C, 0x25, 0x2E, 0x37, 0x40, 0x49, 0x52
 };
 
-static u8 octo_ctrl_fan_curve_max_power_offsets[] = {
+static const u8 octo_ctrl_fan_curve_max_power_offsets[] = {
 	0x15, 0x1E, 0x27, 0x30, 0x39, 0x42, 0x4B, 0x54
 };
 
-static u8 octo_ctrl_fan_curve_fallback_power_offsets[] = {
+static const u8 octo_ctrl_fan_curve_fallback_power_offsets[] = {
 	0x17, 0x20, 0x29, 0x32, 0x3B, 0x44, 0x4D, 0x56
 };
 
@@ -297,18 +339,18 @@ static u8 octo_ctrl_fan_curve_fallback_power_offsets[] = {
 #define QUADRO_SENSOR_START		0x34
 #define QUADRO_VIRTUAL_SENSORS_START	0x3c
 #define QUADRO_FLOW_SENSOR_OFFSET	0x6e
-static u16 quadro_sensor_fan_offsets[] = { 0x70, 0x7D, 0x8A, 0x97 };
+#define QUADRO_FAN_SENSORS_START	0x70
 
 /* Control report offsets for the Quadro */
 #define QUADRO_TEMP_CTRL_OFFSET		0xA
 #define QUADRO_FLOW_PULSES_CTRL_OFFSET	0x6
 /* Fan speed offsets (0-100%) */
-static u16 quadro_ctrl_fan_offsets[] = { 0x36, 0x8b, 0xe0, 0x135 };
+static const u16 quadro_ctrl_fan_offsets[] = { 0x36, 0x8b, 0xe0, 0x135 };
 /* Fan curve "hold min power" and "start boost" offsets */
-static u8 quadro_ctrl_fan_curve_hold_start_offsets[] = { 0x12, 0x1B, 0x24, 0x2D };
-static u8 quadro_ctrl_fan_curve_min_power_offsets[] = { 0x13, 0x1C, 0x25, 0x2E };
-static u8 quadro_ctrl_fan_curve_max_power_offsets[] = { 0x15, 0x1E, 0x27, 0x30 };
-static u8 quadro_ctrl_fan_curve_fallback_power_offsets[] = { 0x17, 0x20, 0x29, 0x32 };
+static const u8 quadro_ctrl_fan_curve_hold_start_offsets[] = { 0x12, 0x1B, 0x24, 0x2D };
+static const u8 quadro_ctrl_fan_curve_min_power_offsets[] = { 0x13, 0x1C, 0x25, 0x2E };
+static const u8 quadro_ctrl_fan_curve_max_power_offsets[] = { 0x15, 0x1E, 0x27, 0x30 };
+static const u8 quadro_ctrl_fan_curve_fallback_power_offsets[] = { 0x17, 0x20, 0x29, 0x32 };
 
 /* Specs of High Flow Next flow sensor */
 #define HIGHFLOWNEXT_NUM_SENSORS	2
@@ -349,7 +391,7 @@ static u8 quadro_ctrl_fan_curve_fallback_power_offsets[] = { 0x17, 0x20, 0x29, 0
 #define LEAKSHIELD_USB_REPORT_UNIT_DL_PER_H		0x0C
 
 /* USB bulk message to report pump RPM and flow rate for pressure calculations */
-static u8 leakshield_usb_report_template[] = {
+static const u8 leakshield_usb_report_template[] = {
 	0x4, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff,
 	0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff, 0x7f, 0xff,
 	0x7f, 0xff, 0x7f, 0xff, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
@@ -375,14 +417,14 @@ static u8 leakshield_usb_report_template[] = {
 #define AQUASTREAMXT_FAN_STATUS_OFFSET		0x1d
 #define AQUASTREAMXT_PUMP_VOLTAGE_OFFSET	0x9
 #define AQUASTREAMXT_PUMP_CURR_OFFSET		0xb
-static u16 aquastreamxt_sensor_fan_offsets[] = { 0x13, 0x1b };
+static const u16 aquastreamxt_sensor_fan_offsets[] = { 0x13, 0x1b };
 
 /* Control report offsets for Aquastream XT */
 #define AQUASTREAMXT_PUMP_MODE_CTRL_OFFSET	0x3
 #define AQUASTREAMXT_PUMP_MODE_CTRL_MANUAL	0x14
 #define AQUASTREAMXT_FAN_MODE_CTRL_OFFSET	0x1a
 #define AQUASTREAMXT_FAN_MODE_CTRL_MANUAL	0x1
-static u16 aquastreamxt_ctrl_fan_offsets[] = { 0x8, 0x1b };
+static const u16 aquastreamxt_ctrl_fan_offsets[] = { 0x8, 0x1b };
 
 /* Specs of the Poweradjust 3 */
 #define POWERADJUST3_SERIAL_START	0x27
@@ -674,89 +716,754 @@ static const char *const label_highflow_speeds[] = {
 	"Flow speed [dL/h]"
 };
 
-struct aqc_fan_structure_offsets {
-	u8 voltage;
-	u8 curr;
-	u8 power;
-	u8 speed;
+/* Sensor value arrays that sensor reports are parsed into */
+enum aqc_sensor_types {
+	AQC_TEMP,
+	AQC_SPEED,
+	AQC_SPEED_MIN,
+	AQC_SPEED_TARGET,
+	AQC_SPEED_MAX,
+	AQC_POWER,
+	AQC_VOLTAGE,
+	AQC_CURRENT,
+	AQC_SENSOR_TYPES
+};
+
+/* The trace header can't see the enum, so it keeps its own count */
+static_assert(AQC_TRACE_SENSOR_TYPES == AQC_SENSOR_TYPES);
+
+#define AQC_SENSORS_VERSION		1
+
+/*
+ * Snapshot of the sensor values from one report, as read from the sensors attribute.
+ * The values follow the header, in the order of enum aqc_sensor_types
+ */
+struct aqc_sensors_record {
+	u16 version;		/* AQC_SENSORS_VERSION */
+	u16 size;		/* Of the header and the values, in bytes */
+	u32 seq;		/* Count of sensor reports parsed, as in the sequence attribute */
+	u64 timestamp;		/* When the report was parsed, in ns from ktime_get_ns() */
+	u8 num_values[AQC_SENSOR_TYPES];	/* Count of values of each type */
+	s32 values[];
+};
+
+/*
+ * Page mapped from the sensors_page debugfs entry. lock is odd while the record is
+ * being updated, so readers retry if it's odd or changed while they read the record
+ */
+struct aqc_sensors_page {
+	u32 lock;
+	u32 reserved;
+	struct aqc_sensors_record record;
+};
+
+/*
+ * Generic netlink family multicasting every parsed sensor report. A message holds
+ * the kind and serial number of the device, so that listeners can pick out the
+ * devices they're interested in, followed by the sensor values of each type as
+ * arrays of s32, in attributes AQC_ATTR_TEMP + type
+ */
+#define AQC_GENL_NAME			"aquacomputer"
+#define AQC_GENL_VERSION		1
+#define AQC_GENL_MCGRP_SENSORS		"sensors"
+
+enum aqc_genl_cmds {
+	AQC_CMD_UNSPEC,
+	AQC_CMD_SENSORS,	/* Sensor report, multicast to AQC_GENL_MCGRP_SENSORS */
+};
+
+enum aqc_genl_attrs {
+	AQC_ATTR_UNSPEC,
+	AQC_ATTR_PAD,
+	AQC_ATTR_KIND,		/* String, as the hwmon name of the device */
+	AQC_ATTR_SERIAL,	/* String, as the serial_number debugfs entry */
+	AQC_ATTR_SEQ,		/* u64, as the sequence attribute */
+	AQC_ATTR_TIMESTAMP,	/* u64, when the report was parsed, in ns from ktime_get_ns() */
+	AQC_ATTR_TEMP,		/* First of AQC_SENSOR_TYPES value arrays */
+	AQC_ATTR_MAX = AQC_ATTR_TEMP + AQC_SENSOR_TYPES - 1
 };
 
-/* Fan structure offsets for Aquaero */
-static struct aqc_fan_structure_offsets aqc_aquaero_fan_structure = {
-	.voltage = AQUAERO_FAN_VOLTAGE_OFFSET,
-	.curr = AQUAERO_FAN_CURRENT_OFFSET,
-	.power = AQUAERO_FAN_POWER_OFFSET,
-	.speed = AQUAERO_FAN_SPEED_OFFSET
+/* Flags of sensor descriptors */
+#define AQC_DESC_SIGNED		BIT(0)	/* Value is a signed 16-bit integer */
+#define AQC_DESC_NA		BIT(1)	/* AQC_SENSOR_NA means the sensor is not connected */
+
+/*
+ * Describes count big endian 16-bit values in the sensor report, placed stride
+ * bytes apart, that are multiplied by scale and stored from slot index of the
+ * type array onwards
+ */
+struct aqc_sensor_desc {
+	u16 offset;
+	s16 stride;
+	u8 count;
+	u8 type;
+	u8 index;
+	u8 flags;
+	s32 scale;
 };
 
-/* Fan structure offsets for Aquastream Ultimate */
-static struct aqc_fan_structure_offsets aqc_aquastreamult_fan_structure = {
-	.voltage = AQUASTREAMULT_FAN_VOLTAGE_OFFSET,
-	.curr = AQUASTREAMULT_FAN_CURRENT_OFFSET,
-	.power = AQUASTREAMULT_FAN_POWER_OFFSET,
-	.speed = AQUASTREAMULT_FAN_SPEED_OFFSET
+#define AQC_SENSOR_DESC(_type, _index, _offset, _count, _stride, _scale, _flags)	\
+	{ .offset = (_offset), .stride = (_stride), .count = (_count), .type = (_type),	\
+	  .index = (_index), .flags = (_flags), .scale = (_scale) }
+
+#define AQC_SENSOR_VALUE(_type, _index, _offset, _scale, _flags)	\
+	AQC_SENSOR_DESC(_type, _index, _offset, 1, 0, _scale, _flags)
+
+#define AQC_TEMP_SENSORS(_index, _offset, _count)	\
+	AQC_SENSOR_DESC(AQC_TEMP, _index, _offset, _count, AQC_SENSOR_SIZE, 10,	\
+			AQC_DESC_SIGNED | AQC_DESC_NA)
+
+#define AQC_FLOW_SENSORS(_index, _offset, _count)	\
+	AQC_SENSOR_DESC(AQC_SPEED, _index, _offset, _count, AQC_SENSOR_SIZE, 1, 0)
+
+/* Speed, power, voltage and current of fans, laid out in structures stride bytes apart */
+#define AQC_FAN_SENSORS(_offset, _count, _stride, _speed, _power, _voltage, _curr)	\
+	AQC_SENSOR_DESC(AQC_SPEED, 0, (_offset) + (_speed), _count, _stride, 1, 0),	\
+	AQC_SENSOR_DESC(AQC_POWER, 0, (_offset) + (_power), _count, _stride, 10000, 0),	\
+	AQC_SENSOR_DESC(AQC_VOLTAGE, 0, (_offset) + (_voltage), _count, _stride, 10, 0),	\
+	AQC_SENSOR_DESC(AQC_CURRENT, 0, (_offset) + (_curr), _count, _stride, 1, 0)
+
+#define AQC_GENERAL_FAN_SENSORS(_offset, _count, _stride)	\
+	AQC_FAN_SENSORS(_offset, _count, _stride, AQC_FAN_SPEED_OFFSET, AQC_FAN_POWER_OFFSET,	\
+			AQC_FAN_VOLTAGE_OFFSET, AQC_FAN_CURRENT_OFFSET)
+
+static const struct aqc_sensor_desc aquaero_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, AQUAERO_SENSOR_START, AQUAERO_NUM_SENSORS),
+	AQC_TEMP_SENSORS(AQUAERO_NUM_SENSORS, AQUAERO_VIRTUAL_SENSOR_START,
+			 AQUAERO_NUM_VIRTUAL_SENSORS),
+	AQC_TEMP_SENSORS(AQUAERO_NUM_SENSORS + AQUAERO_NUM_VIRTUAL_SENSORS,
+			 AQUAERO_CALC_VIRTUAL_SENSOR_START, AQUAERO_NUM_CALC_VIRTUAL_SENSORS),
+	AQC_TEMP_SENSORS(AQUAERO_NUM_SENSORS + AQUAERO_NUM_VIRTUAL_SENSORS +
+			 AQUAERO_NUM_CALC_VIRTUAL_SENSORS,
+			 AQUAERO_AQUABUS_SENSOR_START, AQUAERO_NUM_AQUABUS_SENSORS),
+	AQC_FAN_SENSORS(AQUAERO_FAN_SENSORS_START, AQUAERO_NUM_FANS, AQUAERO_FAN_STRUCT_SIZE,
+			AQUAERO_FAN_SPEED_OFFSET, AQUAERO_FAN_POWER_OFFSET,
+			AQUAERO_FAN_VOLTAGE_OFFSET, AQUAERO_FAN_CURRENT_OFFSET),
+	AQC_FLOW_SENSORS(AQUAERO_NUM_FANS, AQUAERO_FLOW_SENSORS_START, AQUAERO_NUM_FLOW_SENSORS),
+	AQC_SENSOR_DESC(AQC_SPEED, AQUAERO_NUM_FANS + AQUAERO_NUM_FLOW_SENSORS,
+			AQUAERO_AQUABUS_FLOW_SENSORS_START,
+			AQUAERO_NUM_AQUABUS_FLOW_SENSORS, AQC_SENSOR_SIZE, 1,
+			AQC_DESC_SIGNED | AQC_DESC_NA),
 };
 
-/* Fan structure offsets for all devices except those above */
-static struct aqc_fan_structure_offsets aqc_general_fan_structure = {
-	.voltage = AQC_FAN_VOLTAGE_OFFSET,
-	.curr = AQC_FAN_CURRENT_OFFSET,
-	.power = AQC_FAN_POWER_OFFSET,
-	.speed = AQC_FAN_SPEED_OFFSET
+static const struct aqc_sensor_desc d5next_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, D5NEXT_COOLANT_TEMP, D5NEXT_NUM_SENSORS),
+	AQC_TEMP_SENSORS(D5NEXT_NUM_SENSORS, D5NEXT_VIRTUAL_SENSORS_START,
+			 D5NEXT_NUM_VIRTUAL_SENSORS),
+	/* Pump structure comes after the fan one */
+	AQC_GENERAL_FAN_SENSORS(D5NEXT_PUMP_OFFSET, D5NEXT_NUM_FANS,
+				D5NEXT_FAN_OFFSET - D5NEXT_PUMP_OFFSET),
+	AQC_SENSOR_VALUE(AQC_VOLTAGE, 2, D5NEXT_5V_VOLTAGE, 10, 0),
+	AQC_SENSOR_VALUE(AQC_VOLTAGE, 3, D5NEXT_12V_VOLTAGE, 10, 0),
 };
 
-struct aqc_data {
-	struct hid_device *hdev;
-	struct device *hwmon_dev;
-	struct dentry *debugfs;
-	struct mutex mutex;	/* Used for locking access when reading and writing PWM values */
+static const struct aqc_sensor_desc farbwerk_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, FARBWERK_SENSOR_START, FARBWERK_NUM_SENSORS),
+};
+
+static const struct aqc_sensor_desc farbwerk360_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, FARBWERK360_SENSOR_START, FARBWERK360_NUM_SENSORS),
+	AQC_TEMP_SENSORS(FARBWERK360_NUM_SENSORS, FARBWERK360_VIRTUAL_SENSORS_START,
+			 FARBWERK360_NUM_VIRTUAL_SENSORS),
+};
+
+static const struct aqc_sensor_desc octo_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, OCTO_SENSOR_START, OCTO_NUM_SENSORS),
+	AQC_TEMP_SENSORS(OCTO_NUM_SENSORS, OCTO_VIRTUAL_SENSORS_START, OCTO_NUM_VIRTUAL_SENSORS),
+	AQC_GENERAL_FAN_SENSORS(OCTO_FAN_SENSORS_START, OCTO_NUM_FANS, AQC_FAN_STRUCT_SIZE),
+	AQC_FLOW_SENSORS(OCTO_NUM_FANS, OCTO_FLOW_SENSOR_OFFSET, OCTO_NUM_FLOW_SENSORS),
+};
+
+static const struct aqc_sensor_desc quadro_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, QUADRO_SENSOR_START, QUADRO_NUM_SENSORS),
+	AQC_TEMP_SENSORS(QUADRO_NUM_SENSORS, QUADRO_VIRTUAL_SENSORS_START,
+			 QUADRO_NUM_VIRTUAL_SENSORS),
+	AQC_GENERAL_FAN_SENSORS(QUADRO_FAN_SENSORS_START, QUADRO_NUM_FANS, AQC_FAN_STRUCT_SIZE),
+	AQC_FLOW_SENSORS(QUADRO_NUM_FANS, QUADRO_FLOW_SENSOR_OFFSET, QUADRO_NUM_FLOW_SENSORS),
+};
+
+static const struct aqc_sensor_desc highflownext_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, HIGHFLOWNEXT_SENSOR_START, HIGHFLOWNEXT_NUM_SENSORS),
+	AQC_FLOW_SENSORS(0, HIGHFLOWNEXT_FLOW, HIGHFLOWNEXT_NUM_FLOW_SENSORS),
+	AQC_SENSOR_VALUE(AQC_SPEED, 1, HIGHFLOWNEXT_WATER_QUALITY, 1, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 2, HIGHFLOWNEXT_CONDUCTIVITY, 1, 0),
+	AQC_SENSOR_VALUE(AQC_POWER, 0, HIGHFLOWNEXT_POWER, 1000000, 0),
+	AQC_SENSOR_VALUE(AQC_VOLTAGE, 0, HIGHFLOWNEXT_5V_VOLTAGE, 10, 0),
+	AQC_SENSOR_VALUE(AQC_VOLTAGE, 1, HIGHFLOWNEXT_5V_VOLTAGE_USB, 10, 0),
+};
+
+static const struct aqc_sensor_desc leakshield_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, LEAKSHIELD_TEMPERATURE_1, 1),
+	AQC_SENSOR_VALUE(AQC_TEMP, 1, LEAKSHIELD_TEMPERATURE_2, 10, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 0, LEAKSHIELD_PRESSURE_ADJUSTED, 100, AQC_DESC_SIGNED),
+	AQC_SENSOR_VALUE(AQC_SPEED_MIN, 0, LEAKSHIELD_PRESSURE_MIN, 100, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED_TARGET, 0, LEAKSHIELD_PRESSURE_TARGET, 100, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED_MAX, 0, LEAKSHIELD_PRESSURE_MAX, 100, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 1, LEAKSHIELD_PUMP_RPM_IN, 1, AQC_DESC_NA),
+	AQC_SENSOR_VALUE(AQC_SPEED, 2, LEAKSHIELD_FLOW_IN, 1, AQC_DESC_NA),
+	AQC_SENSOR_VALUE(AQC_SPEED, 3, LEAKSHIELD_RESERVOIR_VOLUME, 1, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 4, LEAKSHIELD_RESERVOIR_FILLED, 1, 0),
+};
+
+static const struct aqc_sensor_desc aquastreamult_sensor_descs[] = {
+	AQC_TEMP_SENSORS(0, AQUASTREAMULT_SENSOR_START, AQUASTREAMULT_NUM_SENSORS),
+	AQC_FAN_SENSORS(AQUASTREAMULT_FAN_OFFSET, AQUASTREAMULT_NUM_FANS, 0,
+			AQUASTREAMULT_FAN_SPEED_OFFSET, AQUASTREAMULT_FAN_POWER_OFFSET,
+			AQUASTREAMULT_FAN_VOLTAGE_OFFSET, AQUASTREAMULT_FAN_CURRENT_OFFSET),
+	/* Pump does not follow the standard structure */
+	AQC_SENSOR_VALUE(AQC_SPEED, 1, AQUASTREAMULT_PUMP_OFFSET, 1, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 2, AQUASTREAMULT_PRESSURE_OFFSET, 1, 0),
+	AQC_SENSOR_VALUE(AQC_SPEED, 3, AQUASTREAMULT_FLOW_SENSOR_OFFSET, 1, 0),
+	AQC_SENSOR_VALUE(AQC_POWER, 1, AQUASTREAMULT_PUMP_POWER, 10000, 0),
+	AQC_SENSOR_VALUE(AQC_VOLTAGE, 1, AQUASTREAMULT_PUMP_VOLTAGE, 10, 0),
+	AQC_SENSOR_VALUE(AQC_CURRENT, 1, AQUASTREAMULT_PUMP_CURRENT, 1, 0),
+};
+
+/* Describes a kind of device, shared by all devices of that kind */
+struct aqc_device_info {
 	enum kinds kind;
 	const char *name;
-	const struct attribute_group *groups[8];	/* For max 8 fans */
 
-	int status_report_id;	/* Used for legacy devices, report is stored in buffer */
+	int status_report_id;	/* Used for legacy devices */
 	int ctrl_report_id;
 	int secondary_ctrl_report_id;
 	int secondary_ctrl_report_size;
 	u8 *secondary_ctrl_report;
+	int ctrl_report_delay;	/* Max delay between two ctrl report operations, in ms */
+	int buffer_size;	/* Of the control report, also used for legacy sensor reports */
 
-	ktime_t last_ctrl_report_op;
-	int ctrl_report_delay;	/* Delay between two ctrl report operations, in ms */
+	/* Describe how sensor reports are parsed, on devices that send them */
+	const struct aqc_sensor_desc *sensor_descs;
+	int num_sensor_descs;
+	u8 num_values[AQC_SENSOR_TYPES];	/* Count of sensor values of each type */
 
-	int buffer_size;
-	/*
-	 * Used for writing reports (where supported) and reading
-	 * sensor reports on legacy devices
-	 */
-	u8 *buffer;
-	int checksum_start;
-	int checksum_length;
-	int checksum_offset;
+	/* General info, available across all devices */
+	u8 serial_number_start_offset;
+	u8 firmware_version_offset;
+	u16 power_cycle_count_offset;
 
 	int num_fans;
-	u16 *fan_sensor_offsets;
-	u16 *fan_ctrl_offsets;
+	const u16 *fan_sensor_offsets;	/* Used for legacy devices */
+	const u16 *fan_ctrl_offsets;
+	u32 fan_ctrl_config;		/* Fan attributes in the control report, such as min */
+	u32 pwm_config;			/* Pwm attributes of each fan with fan_ctrl_offsets */
+	unsigned long user_speed_mask;	/* Speed channels that the user provides */
 	int num_temp_sensors;
-	int temp_sensor_start_offset;
+	int temp_sensor_start_offset;	/* Used for legacy devices */
 	int num_virtual_temp_sensors;
-	int virtual_temp_sensor_start_offset;
 	int num_calc_virt_temp_sensors;
-	int calc_virt_temp_sensor_start_offset;
 	int num_aquabus_temp_sensors;
-	int aquabus_temp_sensor_start_offset;
 	u16 temp_ctrl_offset;
-	u16 power_cycle_count_offset;
 	int num_flow_sensors;
-	u8 flow_sensors_start_offset;
+	u8 flow_sensors_start_offset;	/* Used for legacy devices */
 	int num_aquabus_flow_sensors;
-	u8 aquabus_flow_sensors_start_offset;
 	u8 flow_pulses_ctrl_offset;
-	struct aqc_fan_structure_offsets *fan_structure;
-	u8 *fan_curve_min_power_offsets;
-	u8 *fan_curve_max_power_offsets;
+	const u8 *fan_curve_min_power_offsets;
+	const u8 *fan_curve_max_power_offsets;
 	/* Used for both "hold min power" and "start boost" parameters */
-	u8 *fan_curve_hold_start_offsets;
-	u8 *fan_curve_fallback_power_offsets;
+	const u8 *fan_curve_hold_start_offsets;
+	const u8 *fan_curve_fallback_power_offsets;
+
+	/* Label values */
+	const char *const *temp_label;
+	const char *const *virtual_temp_label;
+	const char *const *calc_virtual_temp_label;	/* For Aquaero */
+	const char *const *aquabus_temp_label;		/* For Aquaero */
+	const char *const *speed_label;
+	const char *const *power_label;
+	const char *const *voltage_label;
+	const char *const *current_label;
+} ____cacheline_aligned;
+
+#define AQC_SENSOR_DESCS(_descs)	\
+	.sensor_descs = (_descs), .num_sensor_descs = ARRAY_SIZE(_descs)
+
+/* Control report IDs of most devices */
+#define AQC_CTRL_REPORTS						\
+	.ctrl_report_id = CTRL_REPORT_ID,				\
+	.secondary_ctrl_report_id = SECONDARY_CTRL_REPORT_ID,		\
+	.secondary_ctrl_report_size = SECONDARY_CTRL_REPORT_SIZE,	\
+	.secondary_ctrl_report = secondary_ctrl_report
+
+static const struct aqc_device_info aquaero_info = {
+	.kind = aquaero,
+	.name = "aquaero",
+	.ctrl_report_id = AQUAERO_CTRL_REPORT_ID,
+	.secondary_ctrl_report_id = AQUAERO_SECONDARY_CTRL_REPORT_ID,
+	.secondary_ctrl_report_size = AQUAERO_SECONDARY_CTRL_REPORT_SIZE,
+	.secondary_ctrl_report = aquaero_secondary_ctrl_report,
+	.ctrl_report_delay = CTRL_REPORT_DELAY,
+	.buffer_size = AQUAERO_CTRL_REPORT_SIZE,
+	AQC_SENSOR_DESCS(aquaero_sensor_descs),
+	.serial_number_start_offset = AQUAERO_SERIAL_START,
+	.firmware_version_offset = AQUAERO_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = AQUAERO_NUM_SENSORS + AQUAERO_NUM_VIRTUAL_SENSORS +
+			     AQUAERO_NUM_CALC_VIRTUAL_SENSORS + AQUAERO_NUM_AQUABUS_SENSORS,
+		[AQC_SPEED] = AQUAERO_NUM_FANS + AQUAERO_NUM_FLOW_SENSORS +
+			      AQUAERO_NUM_AQUABUS_FLOW_SENSORS,
+		[AQC_POWER] = AQUAERO_NUM_FANS,
+		[AQC_VOLTAGE] = AQUAERO_NUM_FANS,
+		[AQC_CURRENT] = AQUAERO_NUM_FANS,
+	},
+
+	.num_fans = AQUAERO_NUM_FANS,
+	.fan_ctrl_offsets = aquaero_ctrl_fan_offsets,
+	.fan_ctrl_config = HWMON_F_MIN | HWMON_F_MAX,
+	.pwm_config = HWMON_PWM_INPUT,
+	.num_temp_sensors = AQUAERO_NUM_SENSORS,
+	.num_virtual_temp_sensors = AQUAERO_NUM_VIRTUAL_SENSORS,
+	.num_calc_virt_temp_sensors = AQUAERO_NUM_CALC_VIRTUAL_SENSORS,
+	.num_aquabus_temp_sensors = AQUAERO_NUM_AQUABUS_SENSORS,
+	.temp_ctrl_offset = AQUAERO_TEMP_CTRL_OFFSET,
+	.num_flow_sensors = AQUAERO_NUM_FLOW_SENSORS,
+	.num_aquabus_flow_sensors = AQUAERO_NUM_AQUABUS_FLOW_SENSORS,
+
+	.temp_label = label_temp_sensors,
+	.virtual_temp_label = label_virtual_temp_sensors,
+	.calc_virtual_temp_label = label_aquaero_calc_temp_sensors,
+	.aquabus_temp_label = label_aquaero_aquabus_temp_sensors,
+	.speed_label = label_aquaero_speeds,
+	.power_label = label_fan_power,
+	.voltage_label = label_fan_voltage,
+	.current_label = label_fan_current,
+};
+
+static const struct aqc_device_info d5next_info = {
+	.kind = d5next,
+	.name = "d5next",
+	AQC_CTRL_REPORTS,
+	.ctrl_report_delay = CTRL_REPORT_DELAY,
+	.buffer_size = D5NEXT_CTRL_REPORT_SIZE,
+	AQC_SENSOR_DESCS(d5next_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.power_cycle_count_offset = AQC_POWER_CYCLES,
+	.num_values = {
+		[AQC_TEMP] = D5NEXT_NUM_SENSORS + D5NEXT_NUM_VIRTUAL_SENSORS,
+		[AQC_SPEED] = D5NEXT_NUM_FANS,
+		[AQC_POWER] = D5NEXT_NUM_FANS,
+		[AQC_VOLTAGE] = D5NEXT_NUM_FANS + 2,	/* Plus +5V and +12V */
+		[AQC_CURRENT] = D5NEXT_NUM_FANS,
+	},
+
+	.num_fans = D5NEXT_NUM_FANS,
+	.fan_ctrl_offsets = d5next_ctrl_fan_offsets,
+	.pwm_config = HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
+	.fan_curve_min_power_offsets = d5next_ctrl_fan_curve_min_power_offsets,
+	.fan_curve_max_power_offsets = d5next_ctrl_fan_curve_max_power_offsets,
+	.fan_curve_hold_start_offsets = d5next_ctrl_fan_curve_hold_start_offsets,
+	.fan_curve_fallback_power_offsets = d5next_ctrl_fan_curve_fallback_power_offsets,
+	.num_temp_sensors = D5NEXT_NUM_SENSORS,
+	.num_virtual_temp_sensors = D5NEXT_NUM_VIRTUAL_SENSORS,
+	.temp_ctrl_offset = D5NEXT_TEMP_CTRL_OFFSET,
+
+	.temp_label = label_d5next_temp,
+	.virtual_temp_label = label_virtual_temp_sensors,
+	.speed_label = label_d5next_speeds,
+	.power_label = label_d5next_power,
+	.voltage_label = label_d5next_voltages,
+	.current_label = label_d5next_current,
+};
+
+static const struct aqc_device_info farbwerk_info = {
+	.kind = farbwerk,
+	.name = "farbwerk",
+	AQC_CTRL_REPORTS,
+	AQC_SENSOR_DESCS(farbwerk_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = FARBWERK_NUM_SENSORS,
+	},
+
+	.num_temp_sensors = FARBWERK_NUM_SENSORS,
+
+	.temp_label = label_temp_sensors,
+};
+
+static const struct aqc_device_info farbwerk360_info = {
+	.kind = farbwerk360,
+	.name = "farbwerk360",
+	AQC_CTRL_REPORTS,
+	.buffer_size = FARBWERK360_CTRL_REPORT_SIZE,
+	AQC_SENSOR_DESCS(farbwerk360_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = FARBWERK360_NUM_SENSORS + FARBWERK360_NUM_VIRTUAL_SENSORS,
+	},
+
+	.num_temp_sensors = FARBWERK360_NUM_SENSORS,
+	.num_virtual_temp_sensors = FARBWERK360_NUM_VIRTUAL_SENSORS,
+	.temp_ctrl_offset = FARBWERK360_TEMP_CTRL_OFFSET,
+
+	.temp_label = label_temp_sensors,
+	.virtual_temp_label = label_virtual_temp_sensors,
+};
+
+static const struct aqc_device_info octo_info = {
+	.kind = octo,
+	.name = "octo",
+	AQC_CTRL_REPORTS,
+	.ctrl_report_delay = CTRL_REPORT_DELAY,
+	.buffer_size = OCTO_CTRL_REPORT_SIZE,
+	AQC_SENSOR_DESCS(octo_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.power_cycle_count_offset = AQC_POWER_CYCLES,
+	.num_values = {
+		[AQC_TEMP] = OCTO_NUM_SENSORS + OCTO_NUM_VIRTUAL_SENSORS,
+		[AQC_SPEED] = OCTO_NUM_FANS + OCTO_NUM_FLOW_SENSORS,
+		[AQC_POWER] = OCTO_NUM_FANS,
+		[AQC_VOLTAGE] = OCTO_NUM_FANS,
+		[AQC_CURRENT] = OCTO_NUM_FANS,
+	},
+
+	.num_fans = OCTO_NUM_FANS,
+	.fan_ctrl_offsets = octo_ctrl_fan_offsets,
+	.pwm_config = HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
+	.fan_curve_min_power_offsets = octo_ctrl_fan_curve_min_power_offsets,
+	.fan_curve_max_power_offsets = octo_ctrl_fan_curve_max_power_offsets,
+	.fan_curve_hold_start_offsets = octo_ctrl_fan_curve_hold_start_offsets,
+	.fan_curve_fallback_power_offsets = octo_ctrl_fan_curve_fallback_power_offsets,
+	.num_temp_sensors = OCTO_NUM_SENSORS,
+	.num_virtual_temp_sensors = OCTO_NUM_VIRTUAL_SENSORS,
+	.temp_ctrl_offset = OCTO_TEMP_CTRL_OFFSET,
+	.num_flow_sensors = OCTO_NUM_FLOW_SENSORS,
+	.flow_pulses_ctrl_offset = OCTO_FLOW_PULSES_CTRL_OFFSET,
+
+	.temp_label = label_temp_sensors,
+	.virtual_temp_label = label_virtual_temp_sensors,
+	.speed_label = label_octo_speeds,
+	.power_label = label_fan_power,
+	.voltage_label = label_fan_voltage,
+	.current_label = label_fan_current,
+};
+
+static const struct aqc_device_info quadro_info = {
+	.kind = quadro,
+	.name = "quadro",
+	AQC_CTRL_REPORTS,
+	.ctrl_report_delay = CTRL_REPORT_DELAY,
+	.buffer_size = QUADRO_CTRL_REPORT_SIZE,
+	AQC_SENSOR_DESCS(quadro_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.power_cycle_count_offset = AQC_POWER_CYCLES,
+	.num_values = {
+		[AQC_TEMP] = QUADRO_NUM_SENSORS + QUADRO_NUM_VIRTUAL_SENSORS,
+		[AQC_SPEED] = QUADRO_NUM_FANS + QUADRO_NUM_FLOW_SENSORS,
+		[AQC_POWER] = QUADRO_NUM_FANS,
+		[AQC_VOLTAGE] = QUADRO_NUM_FANS,
+		[AQC_CURRENT] = QUADRO_NUM_FANS,
+	},
+
+	.num_fans = QUADRO_NUM_FANS,
+	.fan_ctrl_offsets = quadro_ctrl_fan_offsets,
+	.pwm_config = HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
+	.fan_curve_min_power_offsets = quadro_ctrl_fan_curve_min_power_offsets,
+	.fan_curve_max_power_offsets = quadro_ctrl_fan_curve_max_power_offsets,
+	.fan_curve_hold_start_offsets = quadro_ctrl_fan_curve_hold_start_offsets,
+	.fan_curve_fallback_power_offsets = quadro_ctrl_fan_curve_fallback_power_offsets,
+	.num_temp_sensors = QUADRO_NUM_SENSORS,
+	.num_virtual_temp_sensors = QUADRO_NUM_VIRTUAL_SENSORS,
+	.temp_ctrl_offset = QUADRO_TEMP_CTRL_OFFSET,
+	.num_flow_sensors = QUADRO_NUM_FLOW_SENSORS,
+	.flow_pulses_ctrl_offset = QUADRO_FLOW_PULSES_CTRL_OFFSET,
+
+	.temp_label = label_temp_sensors,
+	.virtual_temp_label = label_virtual_temp_sensors,
+	.speed_label = label_quadro_speeds,
+	.power_label = label_fan_power,
+	.voltage_label = label_fan_voltage,
+	.current_label = label_fan_current,
+};
+
+static const struct aqc_device_info highflownext_info = {
+	.kind = highflownext,
+	.name = "highflownext",
+	AQC_CTRL_REPORTS,
+	AQC_SENSOR_DESCS(highflownext_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.power_cycle_count_offset = AQC_POWER_CYCLES,
+	.num_values = {
+		[AQC_TEMP] = HIGHFLOWNEXT_NUM_SENSORS,
+		/* Plus water quality and conductivity */
+		[AQC_SPEED] = HIGHFLOWNEXT_NUM_FLOW_SENSORS + 2,
+		[AQC_POWER] = 1,
+		[AQC_VOLTAGE] = 2,
+	},
+
+	.num_temp_sensors = HIGHFLOWNEXT_NUM_SENSORS,
+	.num_flow_sensors = HIGHFLOWNEXT_NUM_FLOW_SENSORS,
+
+	.temp_label = label_highflownext_temp_sensors,
+	.speed_label = label_highflownext_fan_speed,
+	.power_label = label_highflownext_power,
+	.voltage_label = label_highflownext_voltage,
+};
+
+static const struct aqc_device_info leakshield_info = {
+	.kind = leakshield,
+	.name = "leakshield",
+	AQC_CTRL_REPORTS,
+	/* Plus two bytes for checksum */
+	.buffer_size = LEAKSHIELD_USB_REPORT_LENGTH + 2,
+	AQC_SENSOR_DESCS(leakshield_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = LEAKSHIELD_NUM_SENSORS,
+		/* Pressure, pump speed, flow, reservoir volume and how full it is */
+		[AQC_SPEED] = 5,
+		[AQC_SPEED_MIN] = 1,
+		[AQC_SPEED_TARGET] = 1,
+		[AQC_SPEED_MAX] = 1,
+	},
+
+	.num_temp_sensors = LEAKSHIELD_NUM_SENSORS,
+	.user_speed_mask = BIT(1) | BIT(2),	/* Pump speed and flow */
+
+	.temp_label = label_leakshield_temp_sensors,
+	.speed_label = label_leakshield_fan_speed,
+};
+
+static const struct aqc_device_info aquastreamxt_info = {
+	.kind = aquastreamxt,
+	.name = "aquastreamxt",
+	.status_report_id = AQUASTREAMXT_STATUS_REPORT_ID,
+	.ctrl_report_id = AQUASTREAMXT_CTRL_REPORT_ID,
+	.secondary_ctrl_report_id = AQUASTREAMXT_SECONDARY_CTRL_REPORT_ID,
+	.secondary_ctrl_report_size = AQUASTREAMXT_SECONDARY_CTRL_REPORT_SIZE,
+	.secondary_ctrl_report = aquastreamxt_secondary_ctrl_report,
+	/*
+	 * Sensor and control reports are read into buffers of the
+	 * same size, so reserve enough space for both
+	 */
+	.buffer_size = AQUASTREAMXT_SENSOR_REPORT_SIZE > AQUASTREAMXT_CTRL_REPORT_SIZE ?
+		       AQUASTREAMXT_SENSOR_REPORT_SIZE : AQUASTREAMXT_CTRL_REPORT_SIZE,
+	.serial_number_start_offset = AQUASTREAMXT_SERIAL_START,
+	.firmware_version_offset = AQUASTREAMXT_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = AQUASTREAMXT_NUM_SENSORS,
+		[AQC_SPEED] = AQUASTREAMXT_NUM_FANS,
+		[AQC_VOLTAGE] = AQUASTREAMXT_NUM_FANS,
+		[AQC_CURRENT] = 1,	/* Only for the pump */
+	},
+
+	.num_fans = AQUASTREAMXT_NUM_FANS,
+	.fan_sensor_offsets = aquastreamxt_sensor_fan_offsets,
+	.fan_ctrl_offsets = aquastreamxt_ctrl_fan_offsets,
+	.pwm_config = HWMON_PWM_INPUT,
+	.num_temp_sensors = AQUASTREAMXT_NUM_SENSORS,
+	.temp_sensor_start_offset = AQUASTREAMXT_SENSOR_START,
+
+	.temp_label = label_aquastreamxt_temp_sensors,
+	.speed_label = label_d5next_speeds,
+	.voltage_label = label_d5next_voltages,
+	.current_label = label_d5next_current,
+};
+
+static const struct aqc_device_info aquastreamult_info = {
+	.kind = aquastreamult,
+	.name = "aquastreamultimate",
+	AQC_SENSOR_DESCS(aquastreamult_sensor_descs),
+	.serial_number_start_offset = AQC_SERIAL_START,
+	.firmware_version_offset = AQC_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = AQUASTREAMULT_NUM_SENSORS,
+		/* Plus pump speed, pressure and flow */
+		[AQC_SPEED] = AQUASTREAMULT_NUM_FANS + 3,
+		[AQC_POWER] = AQUASTREAMULT_NUM_FANS + 1,
+		[AQC_VOLTAGE] = AQUASTREAMULT_NUM_FANS + 1,
+		[AQC_CURRENT] = AQUASTREAMULT_NUM_FANS + 1,
+	},
+
+	.num_fans = AQUASTREAMULT_NUM_FANS,
+	.num_temp_sensors = AQUASTREAMULT_NUM_SENSORS,
+
+	.temp_label = label_aquastreamult_temp,
+	.speed_label = label_aquastreamult_speeds,
+	.power_label = label_aquastreamult_power,
+	.voltage_label = label_aquastreamult_voltages,
+	.current_label = label_aquastreamult_current,
+};
+
+static const struct aqc_device_info poweradjust3_info = {
+	.kind = poweradjust3,
+	.name = "poweradjust3",
+	.status_report_id = POWERADJUST3_STATUS_REPORT_ID,
+	.buffer_size = POWERADJUST3_SENSOR_REPORT_SIZE,
+	.serial_number_start_offset = POWERADJUST3_SERIAL_START,
+	.firmware_version_offset = POWERADJUST3_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = POWERADJUST3_NUM_SENSORS,
+		[AQC_SPEED] = POWERADJUST3_NUM_FANS + POWERADJUST3_NUM_FLOW_SENSORS,
+		[AQC_VOLTAGE] = POWERADJUST3_NUM_FANS,
+		[AQC_CURRENT] = POWERADJUST3_NUM_FANS,
+	},
+
+	.num_fans = POWERADJUST3_NUM_FANS,
+	.num_temp_sensors = POWERADJUST3_NUM_SENSORS,
+	.temp_sensor_start_offset = POWERADJUST3_SENSOR_START,
+	.num_flow_sensors = POWERADJUST3_NUM_FLOW_SENSORS,
+	.flow_sensors_start_offset = POWERADJUST3_FLOW_SENSOR_OFFSET,
+
+	.temp_label = label_poweradjust3_temp_sensors,
+	.speed_label = label_poweradjust3_speeds,
+	.voltage_label = label_poweradjust3_voltages,
+	.current_label = label_poweradjust3_current,
+};
+
+/* Covers MPS Flow devices */
+static const struct aqc_device_info highflow_info = {
+	.kind = highflow,
+	.name = "highflow",
+	.status_report_id = HIGHFLOW_STATUS_REPORT_ID,
+	.buffer_size = HIGHFLOW_SENSOR_REPORT_SIZE,
+	.serial_number_start_offset = HIGHFLOW_SERIAL_START,
+	.firmware_version_offset = HIGHFLOW_FIRMWARE_VERSION,
+	.num_values = {
+		[AQC_TEMP] = HIGHFLOW_NUM_SENSORS,
+		[AQC_SPEED] = HIGHFLOW_NUM_FLOW_SENSORS,
+	},
+
+	.num_temp_sensors = HIGHFLOW_NUM_SENSORS,
+	.temp_sensor_start_offset = HIGHFLOW_SENSOR_START,
+	.num_flow_sensors = HIGHFLOW_NUM_FLOW_SENSORS,
+	.flow_sensors_start_offset = HIGHFLOW_FLOW_SENSOR_OFFSET,
+
+	.temp_label = label_highflow_temp,
+	.speed_label = label_highflow_speeds,
+};
+
+#define AQC_HIST_BUCKETS		32
+
+/* Histogram of durations, bucket n counts those of 2^n up to 2^(n + 1) ns */
+struct aqc_hist {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	u32 buckets[AQC_HIST_BUCKETS];
+};
+
+/*
+ * Statistics shown in debugfs. Each part is only updated under the lock that its
+ * path already holds, so reading them all at once may be slightly inconsistent
+ */
+struct aqc_stats {
+	u32 reports[256];		/* Reports received, per report ID */
+	u32 reports_ignored;		/* Reports that aren't sensor reports */
+	struct aqc_hist raw_event;	/* Time spent in aqc_raw_event() */
+	struct aqc_hist legacy_poll;	/* Time spent reading sensors of legacy devices */
+	u32 legacy_poll_errors;
+	struct aqc_hist ctrl_get;	/* Round trips of control report requests */
+	struct aqc_hist ctrl_set;
+	struct aqc_hist ctrl_secondary;
+	u32 ctrl_delays;		/* Waits before control report requests */
+	u64 ctrl_delay_ns;
+	u32 ctrl_elided;		/* Writes skipped, as they wouldn't change anything */
+	u32 ctrl_stale;			/* Reads after a write that didn't reflect it */
+	u32 ctrl_backoffs;		/* Times the delay between operations was raised */
+};
+
+/* Values of a control report value that count as unchanged, see pwm[1-8]_deadband */
+struct aqc_ctrl_band {
+	int offset;
+	int type;
+	long lo;
+	long hi;
+};
+
+struct aqc_data {
+	struct list_head node;	/* In aqc_devices */
+	struct hid_device *hdev;
+	struct device *hwmon_dev;
+	struct dentry *debugfs;
+	/*
+	 * Guards the cached control report (buffer and the ctrl_report_ fields) and the
+	 * writes that are yet to reach the device (the pending_ and inflight_ fields).
+	 * Held for reading when values are read from them, and never during a transfer
+	 */
+	struct rw_semaphore ctrl_lock;
+	/*
+	 * Serializes control report transfers and guards their state (io_buffer, the
+	 * adaptive delay, ctrl_sent, ctrl_prev, last_ctrl_report_op and ctrl_unsaved).
+	 * Taken before ctrl_lock. Only its holders update the cached control report
+	 * and the inflight_ fields, so they may read those without ctrl_lock
+	 */
+	struct mutex io_mutex;
+	struct mutex status_mutex;	/* Guards status_buffer on legacy devices */
+	const struct aqc_device_info *info;
+	const struct attribute_group *groups[8];	/* For max 8 fans */
+	u8 pwm_deadband[8];	/* PWM writes closer than this to the current value are skipped */
+
+	struct delayed_work poll_work;	/* Periodically reads the sensors of legacy devices */
+	unsigned int update_interval;	/* In ms */
+
+	ktime_t last_ctrl_report_op;
+
+	/*
+	 * Delay between control report operations, in ms. It starts at ctrl_delay_max,
+	 * tends towards ctrl_delay_floor and backs off when the device doesn't keep up,
+	 * which shows as failed transfers or as reads that don't reflect the previous
+	 * write. For the latter, ctrl_sent holds the last written report and ctrl_prev
+	 * the one read before it. The floor starts at ctrl_delay_min and is raised to
+	 * the delay that a lagging write needed. Only used on devices with an
+	 * info->ctrl_report_delay
+	 */
+	unsigned int ctrl_delay;
+	unsigned int ctrl_delay_floor;
+	unsigned int ctrl_delay_min;
+	unsigned int ctrl_delay_max;
+	bool ctrl_verify;	/* Whether the next read should be checked against ctrl_sent */
+	u8 *ctrl_sent;
+	u8 *ctrl_prev;
+
+	/* Whether buffer holds the control report and when it was read, in jiffies */
+	bool ctrl_report_valid;
+	unsigned long ctrl_report_updated;
+	u8 *io_buffer;		/* For control report transfers */
+
+	/*
+	 * Control report writes are recorded in pending_buffer, with the written bytes
+	 * set in pending_mask, and applied to the report on the device at once by
+	 * aqc_ctrl_flush(). That happens right away, or in ctrl_write_work on ctrl_wq
+	 * after ctrl_write_delay ms or in async mode. While they are sent, the writes
+	 * are moved to the inflight_ fields, so that reading them doesn't wait for the
+	 * device. Pwm writes record their deadband as well, see aqc_set_pwm_ctrl_vals()
+	 */
+	struct workqueue_struct *ctrl_wq;	/* Ordered, for the control report works */
+	struct delayed_work ctrl_write_work;
+	u8 *pending_buffer;
+	unsigned long *pending_mask;
+	struct aqc_ctrl_band pending_bands[8];	/* For max 8 fans */
+	int num_pending_bands;
+	u8 *inflight_buffer;
+	unsigned long *inflight_mask;
+	struct aqc_ctrl_band inflight_bands[8];
+	int num_inflight_bands;
+	bool ctrl_write_pending;
+	bool ctrl_write_inflight;
+	bool ctrl_async;
+	unsigned int ctrl_write_delay;
+	int ctrl_write_status;	/* Result of the last write */
+	bool ctrl_write_save;	/* Whether the pending writes should be saved */
+
+	/*
+	 * In volatile mode, pwm writes aren't followed by the secondary report that
+	 * saves the settings on the device. ctrl_unsaved tells that it's yet to be sent,
+	 * which ctrl_commit_work does ctrl_commit_interval ms after the first such write
+	 */
+	bool ctrl_volatile;
+	bool ctrl_unsaved;
+	struct delayed_work ctrl_commit_work;
+	unsigned int ctrl_commit_interval;
+
+	u8 *buffer;		/* Used for reading and writing reports, where supported */
+	u8 *status_buffer;	/* Used for reading sensor reports on legacy devices */
 
 	/* For differentiating between Aquaero 5 and 6 */
 	enum aquaero_hw_kinds aquaero_hw_kind;
@@ -765,9 +1472,7 @@ struct aqc_data {
 	struct completion aquaero_sensor_report_received;
 
 	/* General info, available across all devices */
-	u8 serial_number_start_offset;
 	u32 serial_number[2];
-	u8 firmware_version_offset;
 	u16 firmware_version;
 
 	/* How many times the device was powered on */
@@ -778,31 +1483,44 @@ struct aqc_data {
 	u32 total_uptime;
 
 	/*
-	 * Sensor values. temp_input has a maximum of 4 physical + 16 virtual + 20 aquabus,
-	 * or 8 physical + 12 virtual + 20 aquabus sensors, depending on the device
+	 * Taken for writing while a sensor report is being parsed, so that readers
+	 * always see values from the same report
 	 */
-	s32 temp_input[40];
-	s32 speed_input[20];	/* Max 8 physical + 12 aquabus */
-	u32 speed_input_min[20];
-	u32 speed_input_target[1];
-	u32 speed_input_max[20];
-	u32 power_input[8];
-	u16 voltage_input[8];
-	u16 current_input[8];
+	seqlock_t sensor_lock;
 
-	/* Label values */
-	const char *const *temp_label;
-	const char *const *virtual_temp_label;
-	const char *const *calc_virtual_temp_label;	/* For Aquaero */
-	const char *const *aquabus_temp_label;		/* For Aquaero */
-	const char *const *speed_label;
-	const char *const *power_label;
-	const char *const *voltage_label;
-	const char *const *current_label;
+	/*
+	 * Sensor values, indexed by enum aqc_sensor_types. Each points into one
+	 * allocation of info->num_values values, laid out in the order of the types
+	 */
+	s32 *sensors[AQC_SENSOR_TYPES];
+	unsigned int num_sensor_values;	/* Of all types */
 
 	unsigned long updated;
+	u64 report_time;	/* When the last report was parsed, in ns */
+	unsigned long report_seq;	/* Count of sensor reports parsed */
+	struct kernfs_node *sequence_kn;	/* For notifying pollers of sequence */
+	struct aqc_sensors_page *sensors_page;	/* Mappable from debugfs, if allocated */
+	struct iio_dev *iio;	/* Set once registered, if enabled */
+	s32 *iio_scan;		/* Scan pushed to the IIO buffer */
+
+	struct aqc_stats stats;
+
+	/*
+	 * Ring of the last raw_depth sensor reports. raw_head counts all reports
+	 * received, the oldest ones are overwritten when the ring is full
+	 */
+	spinlock_t raw_lock;
+	wait_queue_head_t raw_wait;
+	struct aqc_raw_record *raw_ring;
+	unsigned int raw_depth;
+	unsigned long raw_head;
+	bool raw_closed;	/* Set on removal, to release blocked readers */
 };
 
+/* All bound devices, for reading their sensors at once */
+static LIST_HEAD(aqc_devices);
+static DEFINE_MUTEX(aqc_devices_lock);
+
 /* Converts from centi-percent */
 static int aqc_percent_to_pwm(u16 val)
 {
@@ -856,484 +1574,1263 @@ static int aqc_aquastreamxt_convert_fan_rpm(u16 val)
 	return 0;
 }
 
-static void aqc_delay_ctrl_report(struct aqc_data *priv)
+/* Converts pwm to the value that aqc_write() puts into the control report for it */
+static long aqc_pwm_to_ctrl_val(struct aqc_data *priv, int channel, long val)
+{
+	if (priv->info->kind != aquastreamxt)
+		return aqc_pwm_to_percent(val);
+
+	/* The Aquastream XT takes the pump speed in raw units and the fan pwm as is */
+	if (channel == 0)
+		return aqc_aquastreamxt_convert_pump_rpm(aqc_aquastreamxt_pwm_to_rpm(val));
+	return val;
+}
+
+static void aqc_hist_add(struct aqc_hist *hist, u64 ns)
+{
+	hist->buckets[min_t(int, ns ? ilog2(ns) : 0, AQC_HIST_BUCKETS - 1)]++;
+	hist->count++;
+	hist->total_ns += ns;
+	hist->max_ns = max(hist->max_ns, ns);
+}
+
+/* Returns how long it slept for, in ns */
+static u64 aqc_delay_ctrl_report(struct aqc_data *priv)
 {
+	u64 start, slept_ns;
+
 	/*
 	 * If previous read or write is too close to this one, delay the current operation
 	 * to give the device enough time to process the previous one.
 	 */
-	if (priv->ctrl_report_delay) {
+	if (priv->ctrl_delay) {
 		s64 delta = ktime_ms_delta(ktime_get(), priv->last_ctrl_report_op);
 
-		if (delta < priv->ctrl_report_delay)
-			msleep(priv->ctrl_report_delay - delta);
+		if (delta < priv->ctrl_delay) {
+			start = ktime_get_ns();
+			msleep(priv->ctrl_delay - delta);
+
+			slept_ns = ktime_get_ns() - start;
+			trace_aqc_ctrl_delay(priv->hdev, priv->ctrl_delay, slept_ns);
+			priv->stats.ctrl_delays++;
+			priv->stats.ctrl_delay_ns += slept_ns;
+			return slept_ns;
+		}
 	}
+
+	return 0;
 }
 
-/* Expects the mutex to be locked */
-static int aqc_get_ctrl_data(struct aqc_data *priv)
+/* The device didn't keep up, so wait longer between operations. Expects io_mutex */
+static void aqc_ctrl_delay_backoff(struct aqc_data *priv)
 {
-	int ret;
-
-	aqc_delay_ctrl_report(priv);
+	unsigned int delay = max_t(unsigned int, priv->ctrl_delay * 2,
+				   priv->ctrl_delay + CTRL_REPORT_DELAY_STEP);
 
-	memset(priv->buffer, 0x00, priv->buffer_size);
-	ret = hid_hw_raw_request(priv->hdev, priv->ctrl_report_id, priv->buffer, priv->buffer_size,
-				 HID_FEATURE_REPORT, HID_REQ_GET_REPORT);
-	if (ret < 0)
-		ret = -ENODATA;
+	if (!priv->ctrl_sent)
+		return;
 
-	priv->last_ctrl_report_op = ktime_get();
+	priv->stats.ctrl_backoffs++;
+	priv->ctrl_delay = clamp(delay, priv->ctrl_delay_floor, priv->ctrl_delay_max);
+}
 
-	return ret;
+/* The device kept up, so gradually return to the floor. Expects io_mutex */
+static void aqc_ctrl_delay_relax(struct aqc_data *priv)
+{
+	priv->ctrl_delay = max(priv->ctrl_delay - priv->ctrl_delay / 8, priv->ctrl_delay_floor);
 }
 
-/* Expects the mutex to be locked */
-static int aqc_send_ctrl_data(struct aqc_data *priv)
+/*
+ * Checks whether the report just read still has the old value of a byte that the
+ * last write changed, meaning that the device hasn't processed the write yet.
+ * Bytes that the device adjusted on its own don't count. Expects io_mutex
+ */
+static bool aqc_ctrl_data_is_stale(struct aqc_data *priv)
 {
-	int ret;
-	u16 checksum;
+	u8 *prev = priv->ctrl_prev;
+	int i;
 
-	aqc_delay_ctrl_report(priv);
+	for (i = 0; i < priv->info->buffer_size; i++)
+		if (priv->ctrl_sent[i] != prev[i] && priv->io_buffer[i] == prev[i])
+			return true;
 
-	/* Checksum is not needed for Aquaero and Aquastream XT */
-	if (priv->kind != aquaero && priv->kind != aquastreamxt) {
-		/* Init and xorout value for CRC-16/USB is 0xffff */
-		checksum =
-		    crc16(0xffff, priv->buffer + priv->checksum_start, priv->checksum_length);
-		checksum ^= 0xffff;
+	return false;
+}
 
-		/* Place the new checksum at the end of the report */
-		put_unaligned_be16(checksum, priv->buffer + priv->checksum_offset);
-	}
+/* Reads the control report into io_buffer. Expects io_mutex */
+static int aqc_request_ctrl_data(struct aqc_data *priv)
+{
+	u64 delay_ns, start, get_ns;
+	int ret;
 
-	/* Send the patched up report back to the device */
-	ret = hid_hw_raw_request(priv->hdev, priv->ctrl_report_id, priv->buffer, priv->buffer_size,
-				 HID_FEATURE_REPORT, HID_REQ_SET_REPORT);
+	delay_ns = aqc_delay_ctrl_report(priv);
+
+	memset(priv->io_buffer, 0x00, priv->info->buffer_size);
+	start = ktime_get_ns();
+	ret = hid_hw_raw_request(priv->hdev, priv->info->ctrl_report_id, priv->io_buffer,
+				 priv->info->buffer_size, HID_FEATURE_REPORT, HID_REQ_GET_REPORT);
+	get_ns = ktime_get_ns() - start;
+	trace_aqc_ctrl_get(priv->hdev, priv->info->ctrl_report_id, priv->info->buffer_size,
+			   delay_ns, get_ns, ret);
+	aqc_hist_add(&priv->stats.ctrl_get, get_ns);
 	if (ret < 0)
-		goto record_access_and_ret;
+		ret = -ENODATA;
 
-	/* The official software sends this report after every change, so do it here as well */
-	ret =
-	    hid_hw_raw_request(priv->hdev, priv->secondary_ctrl_report_id,
-			       priv->secondary_ctrl_report, priv->secondary_ctrl_report_size,
-			       HID_FEATURE_REPORT, HID_REQ_SET_REPORT);
-record_access_and_ret:
 	priv->last_ctrl_report_op = ktime_get();
 
 	return ret;
 }
 
-/* Refreshes the control buffer and stores value at offset in val */
-static int aqc_get_ctrl_val(struct aqc_data *priv, int offset, long *val, int type)
+/*
+ * Reads the control report into io_buffer, adapting the delay to whether the device
+ * has processed the previous write. Expects io_mutex
+ */
+static int aqc_get_ctrl_data(struct aqc_data *priv)
 {
 	int ret;
 
-	mutex_lock(&priv->mutex);
-
-	ret = aqc_get_ctrl_data(priv);
+	ret = aqc_request_ctrl_data(priv);
 	if (ret < 0)
-		goto unlock_and_return;
+		goto backoff_and_return;
+
+	if (priv->ctrl_verify) {
+		bool stale = false, at_ceiling = false, rejected = false;
+
+		/* Don't build upon a stale report, read it again after longer delays */
+		while (aqc_ctrl_data_is_stale(priv)) {
+			priv->stats.ctrl_stale++;
+			stale = true;
+
+			/*
+			 * Still stale after waiting the longest, so the device rejected or
+			 * adjusted the write rather than lagging behind. Take the report as is
+			 */
+			if (at_ceiling) {
+				aqc_ctrl_delay_backoff(priv);
+				rejected = true;
+				break;
+			}
 
-	switch (type) {
-	case AQC_LE16:
-		*val = (s16)get_unaligned_le16(priv->buffer + offset);
-		break;
-	case AQC_BE16:
-		*val = (s16)get_unaligned_be16(priv->buffer + offset);
-		break;
-	case AQC_8:
-		*val = priv->buffer[offset];
-		break;
-	default:
-		ret = -EINVAL;
-		break;
+			aqc_ctrl_delay_backoff(priv);
+			at_ceiling = priv->ctrl_delay >= priv->ctrl_delay_max;
+			ret = aqc_request_ctrl_data(priv);
+			if (ret < 0)
+				goto backoff_and_return;
+		}
+
+		priv->ctrl_verify = false;
+		if (!stale)
+			aqc_ctrl_delay_relax(priv);
+		else if (!rejected)
+			/* The device needed this long to process the write, don't go below it */
+			priv->ctrl_delay_floor = max(priv->ctrl_delay_floor, priv->ctrl_delay);
 	}
 
-unlock_and_return:
-	mutex_unlock(&priv->mutex);
+	/* Keep what the next write is based on, to verify it afterwards */
+	memcpy(priv->ctrl_prev, priv->io_buffer, priv->info->buffer_size);
+
+	return ret;
+
+backoff_and_return:
+	aqc_ctrl_delay_backoff(priv);
 	return ret;
 }
 
-static int aqc_set_buffer_val(u8 *buffer, int offset, long val, int type)
+/*
+ * Checks whether the control report in buffer was read recently enough.
+ * Expects ctrl_lock or io_mutex to be held
+ */
+static bool aqc_ctrl_data_is_fresh(struct aqc_data *priv)
 {
-	switch (type) {
-	case AQC_LE16:
-		put_unaligned_le16((u16)val, buffer + offset);
-		return 0;
-	case AQC_BE16:
-		put_unaligned_be16((u16)val, buffer + offset);
-		return 0;
-	case AQC_8:
-		buffer[offset] = (u8)val;
-		return 0;
-	default:
-		return -EINVAL;
-	}
+	unsigned int cache_time = READ_ONCE(ctrl_cache_time);
+
+	return priv->ctrl_report_valid && cache_time != 0 &&
+	       time_before(jiffies, priv->ctrl_report_updated + msecs_to_jiffies(cache_time));
 }
 
-/* Refreshes the control buffer, updates values at offsets and writes buffer to device */
-static int aqc_set_ctrl_vals(struct aqc_data *priv, int *offsets, long *values, int *types, int len)
+/*
+ * Keeps the control report in io_buffer as the cached one, or marks the cached one
+ * as invalid. Expects io_mutex and ctrl_lock to be held for writing
+ */
+static void aqc_cache_ctrl_data(struct aqc_data *priv, bool valid)
 {
-	int ret, i;
+	if (valid)
+		memcpy(priv->buffer, priv->io_buffer, priv->info->buffer_size);
+	priv->ctrl_report_valid = valid;
+	priv->ctrl_report_updated = jiffies;
+}
 
-	mutex_lock(&priv->mutex);
+/*
+ * Reuses the control report already in buffer if it's fresh, otherwise requests
+ * it from the device and caches it. Expects io_mutex
+ */
+static int aqc_get_cached_ctrl_data(struct aqc_data *priv)
+{
+	int ret;
 
-	ret = aqc_get_ctrl_data(priv);
-	if (ret < 0)
-		goto unlock_and_return;
+	if (aqc_ctrl_data_is_fresh(priv))
+		return 0;
 
-	for (i = 0; i < len; i++) {
-		ret = aqc_set_buffer_val(priv->buffer, offsets[i], values[i], types[i]);
-		if (ret < 0)
-			goto unlock_and_return;
-	}
+	ret = aqc_get_ctrl_data(priv);
 
-	ret = aqc_send_ctrl_data(priv);
+	down_write(&priv->ctrl_lock);
+	aqc_cache_ctrl_data(priv, ret >= 0);
+	up_write(&priv->ctrl_lock);
 
-unlock_and_return:
-	mutex_unlock(&priv->mutex);
 	return ret;
 }
 
-/* Refreshes the control buffer, updates value at offset and writes buffer to device */
-static int aqc_set_ctrl_val(struct aqc_data *priv, int offset, long val, int type)
+/* Sends the secondary report, which makes the device save its settings. Expects io_mutex */
+static int aqc_send_secondary_ctrl_data(struct aqc_data *priv, u64 *secondary_ns)
 {
-	return aqc_set_ctrl_vals(priv, &offset, &val, &type, 1);
+	const struct aqc_device_info *info = priv->info;
+	u64 start;
+	int ret;
+
+	start = ktime_get_ns();
+	ret =
+	    hid_hw_raw_request(priv->hdev, info->secondary_ctrl_report_id,
+			       info->secondary_ctrl_report, info->secondary_ctrl_report_size,
+			       HID_FEATURE_REPORT, HID_REQ_SET_REPORT);
+	*secondary_ns = ktime_get_ns() - start;
+	aqc_hist_add(&priv->stats.ctrl_secondary, *secondary_ns);
+	if (ret >= 0)
+		priv->ctrl_unsaved = false;
+
+	return ret;
 }
 
-static umode_t aqc_is_visible(const void *data, enum hwmon_sensor_types type, u32 attr, int channel)
+/*
+ * Sends io_buffer to the device. Unless save is set, the secondary report isn't sent
+ * and is left to aqc_ctrl_commit(). Expects io_mutex
+ */
+static int aqc_send_ctrl_data(struct aqc_data *priv, bool save)
+{
+	const struct aqc_device_info *info = priv->info;
+	u64 delay_ns, start, set_ns, secondary_ns = 0;
+	unsigned int commit_interval;
+	int ret;
+	u16 checksum;
+
+	delay_ns = aqc_delay_ctrl_report(priv);
+
+	/* Checksum is not needed for Aquaero and Aquastream XT */
+	if (info->kind != aquaero && info->kind != aquastreamxt) {
+		/* Init and xorout value for CRC-16/USB is 0xffff */
+		checksum = crc16(0xffff, priv->io_buffer + AQC_CHECKSUM_START,
+				 info->buffer_size - AQC_CHECKSUM_START - 2);
+		checksum ^= 0xffff;
+
+		/* Place the new checksum at the end of the report */
+		put_unaligned_be16(checksum, priv->io_buffer + info->buffer_size - 2);
+	}
+
+	/* Send the patched up report back to the device */
+	start = ktime_get_ns();
+	ret = hid_hw_raw_request(priv->hdev, info->ctrl_report_id, priv->io_buffer,
+				 info->buffer_size, HID_FEATURE_REPORT, HID_REQ_SET_REPORT);
+	set_ns = ktime_get_ns() - start;
+	aqc_hist_add(&priv->stats.ctrl_set, set_ns);
+	if (ret < 0) {
+		aqc_ctrl_delay_backoff(priv);
+		goto record_access_and_ret;
+	}
+
+	/* Check the next read for whether the device has processed this write */
+	if (priv->ctrl_sent) {
+		memcpy(priv->ctrl_sent, priv->io_buffer, info->buffer_size);
+		priv->ctrl_verify = true;
+	}
+
+	if (save) {
+		/* The official software sends this report after every change, so do it as well */
+		ret = aqc_send_secondary_ctrl_data(priv, &secondary_ns);
+	} else if (!priv->ctrl_unsaved) {
+		priv->ctrl_unsaved = true;
+		commit_interval = READ_ONCE(priv->ctrl_commit_interval);
+		if (commit_interval)
+			queue_delayed_work(priv->ctrl_wq, &priv->ctrl_commit_work,
+					   msecs_to_jiffies(commit_interval));
+	}
+record_access_and_ret:
+	trace_aqc_ctrl_set(priv->hdev, info->ctrl_report_id, info->buffer_size,
+			   info->secondary_ctrl_report_id,
+			   save ? info->secondary_ctrl_report_size : 0, delay_ns, set_ns,
+			   secondary_ns, ret);
+	priv->last_ctrl_report_op = ktime_get();
+
+	return ret;
+}
+
+/*
+ * Sends the secondary report on its own, saving the settings written in volatile mode.
+ * Expects io_mutex
+ */
+static int aqc_ctrl_commit(struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	u64 delay_ns, secondary_ns;
+	int ret;
+
+	delay_ns = aqc_delay_ctrl_report(priv);
+	ret = aqc_send_secondary_ctrl_data(priv, &secondary_ns);
+	trace_aqc_ctrl_commit(priv->hdev, info->secondary_ctrl_report_id,
+			      info->secondary_ctrl_report_size, delay_ns, secondary_ns, ret);
+	priv->last_ctrl_report_op = ktime_get();
+
+	return ret;
+}
+
+/* Saves the settings written in volatile mode, ctrl_commit_interval ms after the first */
+static void aqc_ctrl_commit_work(struct work_struct *work)
+{
+	struct aqc_data *priv = container_of(to_delayed_work(work), struct aqc_data,
+					     ctrl_commit_work);
+	int ret;
+
+	mutex_lock(&priv->io_mutex);
+
+	if (priv->ctrl_unsaved) {
+		ret = aqc_ctrl_commit(priv);
+		if (ret < 0)
+			hid_warn(priv->hdev, "saving control report failed (%d)\n", ret);
+	}
+
+	mutex_unlock(&priv->io_mutex);
+}
+
+/* Checks whether writes are waiting to be sent or being sent. Expects ctrl_lock to be held */
+static bool aqc_ctrl_write_queued(struct aqc_data *priv)
+{
+	return priv->ctrl_write_pending || priv->ctrl_write_inflight;
+}
+
+/* Size of a control report value of type, in bytes */
+static int aqc_ctrl_val_size(int type)
 {
-	const struct aqc_data *priv = data;
-
 	switch (type) {
-	case hwmon_temp:
-		if (channel < priv->num_temp_sensors) {
-			switch (attr) {
-			case hwmon_temp_label:
-			case hwmon_temp_input:
-				return 0444;
-			case hwmon_temp_offset:
-				if (priv->temp_ctrl_offset != 0)
-					return 0644;
-				break;
-			default:
-				break;
-			}
+	case AQC_LE16:
+	case AQC_BE16:
+		return 2;
+	case AQC_8:
+		return 1;
+	default:
+		return -EINVAL;
+	}
+}
+
+static int aqc_get_buffer_val(u8 *buffer, int offset, long *val, int type)
+{
+	switch (type) {
+	case AQC_LE16:
+		*val = (s16)get_unaligned_le16(buffer + offset);
+		return 0;
+	case AQC_BE16:
+		*val = (s16)get_unaligned_be16(buffer + offset);
+		return 0;
+	case AQC_8:
+		*val = buffer[offset];
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static int aqc_set_buffer_val(u8 *buffer, int offset, long val, int type)
+{
+	switch (type) {
+	case AQC_LE16:
+		put_unaligned_le16((u16)val, buffer + offset);
+		return 0;
+	case AQC_BE16:
+		put_unaligned_be16((u16)val, buffer + offset);
+		return 0;
+	case AQC_8:
+		buffer[offset] = (u8)val;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+/*
+ * Copies the bytes of the value at offset, as they will be once queued writes are sent,
+ * into bytes. Those that weren't written are taken from the cached report if cached is
+ * set, otherwise -ENODATA is returned. Expects ctrl_lock to be held
+ */
+static int aqc_get_ctrl_view(struct aqc_data *priv, int offset, int type, u8 *bytes,
+			     bool cached)
+{
+	int size = aqc_ctrl_val_size(type), i;
+
+	if (size < 0)
+		return size;
+
+	for (i = 0; i < size; i++) {
+		if (test_bit(offset + i, priv->pending_mask))
+			bytes[i] = priv->pending_buffer[offset + i];
+		else if (test_bit(offset + i, priv->inflight_mask))
+			bytes[i] = priv->inflight_buffer[offset + i];
+		else if (cached)
+			bytes[i] = priv->buffer[offset + i];
+		else
+			return -ENODATA;
+	}
+
+	return 0;
+}
+
+/* Like aqc_get_ctrl_view(), but for the values at offsets. Expects ctrl_lock to be held */
+static int aqc_get_ctrl_view_vals(struct aqc_data *priv, int *offsets, long *values, int *types,
+				  int len, bool cached)
+{
+	u8 bytes[2];
+	int ret, i;
+
+	for (i = 0; i < len; i++) {
+		ret = aqc_get_ctrl_view(priv, offsets[i], types[i], bytes, cached);
+		if (ret < 0)
+			return ret;
+
+		aqc_get_buffer_val(bytes, 0, &values[i], types[i]);
+	}
+
+	return 0;
+}
+
+/*
+ * Stores values at offsets in values, as they will be once queued writes are sent.
+ * The control report is only read again if it's stale and the values weren't written
+ */
+static int aqc_get_ctrl_vals(struct aqc_data *priv, int *offsets, long *values, int *types, int len)
+{
+	int ret;
+
+	down_read(&priv->ctrl_lock);
+	ret = aqc_get_ctrl_view_vals(priv, offsets, values, types, len,
+				     aqc_ctrl_data_is_fresh(priv));
+	up_read(&priv->ctrl_lock);
+	if (ret != -ENODATA)
+		return ret;
+
+	/* Holding the device keeps the refreshed report from being replaced meanwhile */
+	mutex_lock(&priv->io_mutex);
+	ret = aqc_get_cached_ctrl_data(priv);
+	if (ret >= 0) {
+		down_read(&priv->ctrl_lock);
+		ret = aqc_get_ctrl_view_vals(priv, offsets, values, types, len, true);
+		up_read(&priv->ctrl_lock);
+	}
+	mutex_unlock(&priv->io_mutex);
+
+	return ret;
+}
+
+/* Refreshes the control buffer if it's stale and stores value at offset in val */
+static int aqc_get_ctrl_val(struct aqc_data *priv, int offset, long *val, int type)
+{
+	return aqc_get_ctrl_vals(priv, &offset, val, &type, 1);
+}
+
+static bool aqc_ctrl_band_contains(const struct aqc_ctrl_band *band, long val)
+{
+	return val >= min(band->lo, band->hi) && val <= max(band->lo, band->hi);
+}
+
+/*
+ * Checks whether the values are already at offsets, as written or in a fresh cached
+ * report, or within band for the first one. Expects ctrl_lock to be held
+ */
+static bool aqc_ctrl_vals_unchanged(struct aqc_data *priv, int *offsets, long *values,
+				    int *types, int len, const struct aqc_ctrl_band *band)
+{
+	bool cached = aqc_ctrl_data_is_fresh(priv);
+	u8 cur[2], new[2];
+	long cur_val;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (aqc_get_ctrl_view(priv, offsets[i], types[i], cur, cached) < 0)
+			return false;
+
+		if (i == 0 && band) {
+			aqc_get_buffer_val(cur, 0, &cur_val, types[i]);
+			if (aqc_ctrl_band_contains(band, cur_val))
+				continue;
 		}
 
-		if (channel <
-		    priv->num_temp_sensors + priv->num_virtual_temp_sensors +
-		    priv->num_calc_virt_temp_sensors + priv->num_aquabus_temp_sensors)
-			switch (attr) {
-			case hwmon_temp_label:
-			case hwmon_temp_input:
-				return 0444;
-			default:
-				break;
-			}
-		break;
-	case hwmon_pwm:
-		if (priv->fan_ctrl_offsets && channel < priv->num_fans) {
-			switch (priv->kind) {
-			case aquaero:
-				switch (attr) {
-				case hwmon_pwm_input:
-					return 0644;
-				case hwmon_pwm_mode:
-					if ((priv->aquaero_hw_kind == aquaero5 && channel == 3) ||
-					    priv->aquaero_hw_kind == aquaero6)
-						return 0644;
-					break;
-				default:
-					break;
-				}
-				break;
-			case aquastreamxt:
-				switch (attr) {
-				case hwmon_pwm_input:
-					return 0644;
-				default:
-					break;
-				}
-				break;
-			case d5next:
-			case octo:
-			case quadro:
-				switch (attr) {
-				case hwmon_pwm_enable:
-					return 0644;
-				}
-				fallthrough;
-			default:
-				switch (attr) {
-				case hwmon_pwm_input:
-				case hwmon_pwm_auto_channels_temp:
-					return 0644;
-				default:
-					break;
-				}
-				break;
-			}
+		aqc_set_buffer_val(new, 0, values[i], types[i]);
+		if (memcmp(cur, new, aqc_ctrl_val_size(types[i])))
+			return false;
+	}
+
+	return true;
+}
+
+/* Stops keeping the value at offset within a deadband. Expects ctrl_lock held for writing */
+static void aqc_drop_ctrl_band(struct aqc_data *priv, int offset)
+{
+	int i;
+
+	for (i = 0; i < priv->num_pending_bands; i++) {
+		if (priv->pending_bands[i].offset == offset) {
+			priv->pending_bands[i] = priv->pending_bands[--priv->num_pending_bands];
+			return;
 		}
+	}
+}
+
+/*
+ * Applies the queued writes to the control report as it is on the device and sends it,
+ * unless that wouldn't change anything. Returns the result, or that of the last write
+ * if none are queued. Expects io_mutex
+ */
+static int aqc_ctrl_flush(struct aqc_data *priv)
+{
+	int size = priv->info->buffer_size;
+	struct aqc_ctrl_band *band;
+	bool save, sent = false;
+	long cur;
+	int ret, i;
+
+	down_write(&priv->ctrl_lock);
+
+	if (!priv->ctrl_write_pending) {
+		ret = priv->ctrl_write_status;
+		up_write(&priv->ctrl_lock);
+		return ret;
+	}
+
+	/* Keep the writes visible to readers while they are sent */
+	memcpy(priv->inflight_buffer, priv->pending_buffer, size);
+	bitmap_copy(priv->inflight_mask, priv->pending_mask, size);
+	bitmap_zero(priv->pending_mask, size);
+	memcpy(priv->inflight_bands, priv->pending_bands, sizeof(priv->pending_bands));
+	priv->num_inflight_bands = priv->num_pending_bands;
+	priv->num_pending_bands = 0;
+	save = priv->ctrl_write_save;
+	priv->ctrl_write_save = false;
+	priv->ctrl_write_pending = false;
+	priv->ctrl_write_inflight = true;
+	up_write(&priv->ctrl_lock);
+
+	/* The inflight fields only change with io_mutex held, so they're read without ctrl_lock */
+	ret = aqc_get_ctrl_data(priv);
+	if (ret < 0)
+		goto update_and_return;
+
+	for_each_set_bit(i, priv->inflight_mask, size)
+		priv->io_buffer[i] = priv->inflight_buffer[i];
+
+	/* Pwm values within their deadband stay as the device has them */
+	for (i = 0; i < priv->num_inflight_bands; i++) {
+		band = &priv->inflight_bands[i];
+		if (aqc_get_buffer_val(priv->ctrl_prev, band->offset, &cur, band->type) == 0 &&
+		    aqc_ctrl_band_contains(band, cur))
+			aqc_set_buffer_val(priv->io_buffer, band->offset, cur, band->type);
+	}
+
+	if (!memcmp(priv->io_buffer, priv->ctrl_prev, size)) {
+		priv->stats.ctrl_elided++;
+		goto update_and_return;
+	}
+
+	ret = aqc_send_ctrl_data(priv, save);
+	sent = true;
+
+update_and_return:
+	down_write(&priv->ctrl_lock);
+	bitmap_zero(priv->inflight_mask, size);
+	priv->num_inflight_bands = 0;
+	priv->ctrl_write_inflight = false;
+	/* The device may adjust the report it was sent, so it's read again next time */
+	aqc_cache_ctrl_data(priv, ret >= 0 && !sent);
+	WRITE_ONCE(priv->ctrl_write_status, ret < 0 ? ret : 0);
+	up_write(&priv->ctrl_lock);
+
+	return ret < 0 ? ret : 0;
+}
+
+/*
+ * Records values at offsets as control report writes, which aqc_ctrl_flush() applies
+ * to the report on the device. Unless writes are deferred or async, that happens right
+ * away and the result is returned. Writes that wouldn't change the values as they are
+ * known are skipped. If band is set, the first value is kept as it is on the device
+ * when that's within band. Unless save is set, the secondary report isn't sent along,
+ * see aqc_send_ctrl_data()
+ */
+static int __aqc_set_ctrl_vals(struct aqc_data *priv, int *offsets, long *values, int *types,
+			       int len, bool save, const struct aqc_ctrl_band *band)
+{
+	struct aqc_ctrl_band *pending_band;
+	bool queued;
+	int ret, i;
+
+	for (i = 0; i < len; i++)
+		if (aqc_ctrl_val_size(types[i]) < 0)
+			return -EINVAL;
+
+	down_write(&priv->ctrl_lock);
+
+	if (aqc_ctrl_vals_unchanged(priv, offsets, values, types, len, band)) {
+		priv->stats.ctrl_elided++;
+		/* Unless queued, the write is done, so the result of earlier ones is outdated */
+		if (!aqc_ctrl_write_queued(priv))
+			WRITE_ONCE(priv->ctrl_write_status, 0);
+		up_write(&priv->ctrl_lock);
+		return 0;
+	}
+
+	for (i = 0; i < len; i++) {
+		aqc_set_buffer_val(priv->pending_buffer, offsets[i], values[i], types[i]);
+		bitmap_set(priv->pending_mask, offsets[i], aqc_ctrl_val_size(types[i]));
+		aqc_drop_ctrl_band(priv, offsets[i]);
+	}
+
+	/* There is one band per pwm channel at most, as each writes its own offset */
+	if (band && priv->num_pending_bands < ARRAY_SIZE(priv->pending_bands)) {
+		pending_band = &priv->pending_bands[priv->num_pending_bands++];
+		*pending_band = *band;
+		pending_band->offset = offsets[0];
+		pending_band->type = types[0];
+	}
+
+	queued = priv->ctrl_write_pending;
+	priv->ctrl_write_pending = true;
+	/* Save the collected writes if any of them should be */
+	priv->ctrl_write_save |= save;
+
+	if (priv->ctrl_async || priv->ctrl_write_delay) {
+		if (!queued)
+			queue_delayed_work(priv->ctrl_wq, &priv->ctrl_write_work,
+					   msecs_to_jiffies(priv->ctrl_write_delay));
+		up_write(&priv->ctrl_lock);
+		return 0;
+	}
+
+	up_write(&priv->ctrl_lock);
+
+	/* Otherwise, send them right away, along with writes queued before */
+	mutex_lock(&priv->io_mutex);
+	ret = aqc_ctrl_flush(priv);
+	mutex_unlock(&priv->io_mutex);
+
+	return ret;
+}
+
+/* Sends control report writes collected by aqc_set_ctrl_vals() */
+static void aqc_ctrl_write_work(struct work_struct *work)
+{
+	struct aqc_data *priv = container_of(to_delayed_work(work), struct aqc_data,
+					     ctrl_write_work);
+	bool pending;
+	int ret = 0;
+
+	mutex_lock(&priv->io_mutex);
+
+	/* Writes that are sent right away may have taken these along */
+	down_read(&priv->ctrl_lock);
+	pending = priv->ctrl_write_pending;
+	up_read(&priv->ctrl_lock);
+	if (pending)
+		ret = aqc_ctrl_flush(priv);
+
+	mutex_unlock(&priv->io_mutex);
+
+	if (ret < 0)
+		hid_warn(priv->hdev, "queued control report write failed (%d)\n", ret);
+}
+
+static int aqc_set_ctrl_vals(struct aqc_data *priv, int *offsets, long *values, int *types, int len)
+{
+	return __aqc_set_ctrl_vals(priv, offsets, values, types, len, true, NULL);
+}
+
+/*
+ * Like aqc_set_ctrl_vals(), but doesn't save the settings on the device in volatile mode,
+ * and keeps the pwm value, which comes first, as it is if that's within band
+ */
+static int aqc_set_pwm_ctrl_vals(struct aqc_data *priv, int *offsets, long *values, int *types,
+				 int len, const struct aqc_ctrl_band *band)
+{
+	return __aqc_set_ctrl_vals(priv, offsets, values, types, len,
+				   !READ_ONCE(priv->ctrl_volatile), band);
+}
+
+/* Refreshes the control buffer, updates value at offset and writes buffer to device */
+static int aqc_set_ctrl_val(struct aqc_data *priv, int offset, long val, int type)
+{
+	return aqc_set_ctrl_vals(priv, &offset, &val, &type, 1);
+}
+
+/*
+ * Only attributes that the device has are declared, see aqc_build_chip_info(),
+ * so this only picks their mode
+ */
+static umode_t aqc_is_visible(const void *data, enum hwmon_sensor_types type, u32 attr, int channel)
+{
+	const struct aqc_data *priv = data;
+	const struct aqc_device_info *info = priv->info;
+
+	switch (type) {
+	case hwmon_chip:
+	case hwmon_pwm:
+		return 0644;
+	case hwmon_temp:
+		if (attr == hwmon_temp_offset)
+			return 0644;
 		break;
 	case hwmon_fan:
 		switch (attr) {
 		case hwmon_fan_input:
-		case hwmon_fan_label:
-			switch (priv->kind) {
-			case aquastreamult:
-				/*
-				 * Special case to support pump RPM, fan RPM,
-				 * pressure and flow sensor
-				 */
-				if (channel < 4)
-					return 0444;
-				break;
-			case highflownext:
-				/*
-				 * Special case to support flow sensor, water quality
-				 * and conductivity
-				 */
-				if (channel < 3)
-					return 0444;
-				break;
-			case leakshield:
-				/* Special case for user-provided Leakshield sensors */
-				if (channel == 1 || channel == 2)
-					return 0644;
-				if (channel < 5)
-					return 0444;
-				break;
-			case aquaero:
-			case quadro:
-			case octo:
-			case highflow:
-			case poweradjust3:
-				/* Special case to support flow sensors */
-				if (channel < priv->num_fans +
-				    priv->num_flow_sensors +
-				    priv->num_aquabus_flow_sensors)
-					return 0444;
-				break;
-			default:
-				if (channel < priv->num_fans)
-					return 0444;
-				break;
-			}
+			if (test_bit(channel, &info->user_speed_mask))
+				return 0644;
 			break;
 		case hwmon_fan_min:
 		case hwmon_fan_max:
-			if (priv->kind == aquaero && channel < priv->num_fans)
+			if (channel < info->num_fans && (info->fan_ctrl_config & BIT(attr)))
 				return 0644;
-			fallthrough;
-		case hwmon_fan_target:
-			/* Special case for Leakshield pressure sensor */
-			if (priv->kind == leakshield && channel == 0)
-				return 0444;
 			break;
 		case hwmon_fan_pulses:
-			/* Special case for Quadro/Octo flow sensor */
-			if (channel == priv->num_fans) {
-				switch (priv->kind) {
-				case quadro:
-				case octo:
-					return 0644;
-				default:
-					break;
-				}
-			}
-			break;
+			return 0644;
 		default:
 			break;
 		}
 		break;
-	case hwmon_power:
-		switch (priv->kind) {
-		case aquastreamult:
-			/* Special case to support pump and fan power */
-			if (channel < 2)
-				return 0444;
-			break;
-		case highflownext:
-			/* Special case to support one power sensor */
-			if (channel == 0)
-				return 0444;
-			break;
-		case aquastreamxt:
-		case poweradjust3:
-			break;
-		default:
-			if (channel < priv->num_fans)
-				return 0444;
-			break;
-		}
-		break;
-	case hwmon_curr:
-		switch (priv->kind) {
-		case aquastreamult:
-			/* Special case to support pump and fan current */
-			if (channel < 2)
-				return 0444;
-			break;
-		case aquastreamxt:
-			/* Special case to support pump current */
-			if (channel == 0)
-				return 0444;
-			break;
-		default:
-			if (channel < priv->num_fans)
-				return 0444;
-			break;
-		}
-		break;
-	case hwmon_in:
-		switch (priv->kind) {
-		case d5next:
-			/* Special case to support +5V and +12V voltage sensors */
-			if (channel < priv->num_fans + 2)
-				return 0444;
-			break;
-		case aquastreamult:
-		case highflownext:
-			/* Special case to support two voltage sensors */
-			if (channel < 2)
-				return 0444;
-			break;
-		default:
-			if (channel < priv->num_fans)
-				return 0444;
-			break;
-		}
-		break;
 	default:
 		break;
 	}
 
+	return 0444;
+}
+
+/* Stores a raw sensor report in history, called from both process and interrupt context */
+static void aqc_raw_push(struct aqc_data *priv, u8 report_id, const u8 *data, int size)
+{
+	struct aqc_raw_record *rec;
+	unsigned long flags;
+
+	if (!priv->raw_ring)
+		return;
+
+	spin_lock_irqsave(&priv->raw_lock, flags);
+
+	rec = &priv->raw_ring[priv->raw_head % priv->raw_depth];
+	rec->timestamp = ktime_get_ns();
+	rec->seq = priv->raw_head;
+	rec->size = size;
+	rec->report_id = report_id;
+	memcpy(rec->data, data, min_t(int, size, RAW_REPORT_DATA_SIZE));
+	priv->raw_head++;
+
+	spin_unlock_irqrestore(&priv->raw_lock, flags);
+
+	wake_up_interruptible(&priv->raw_wait);
+}
+
+/* Wakes up userspace waiting for new sensor readings, safe to call from interrupt context */
+static void aqc_notify_report(struct aqc_data *priv)
+{
+	struct kernfs_node *kn = READ_ONCE(priv->sequence_kn);
+
+	if (kn)
+		sysfs_notify_dirent(kn);
+}
+
+/* Sensor readings older than this are considered stale, in jiffies */
+static unsigned long aqc_sensor_timeout(struct aqc_data *priv)
+{
+	/* Allow for one missed report or read */
+	return 2 * msecs_to_jiffies(READ_ONCE(priv->update_interval));
+}
+
+static const struct genl_multicast_group aqc_genl_mcgrps[] = {
+	{ .name = AQC_GENL_MCGRP_SENSORS },
+};
+
+static struct genl_family aqc_genl_family __ro_after_init = {
+	.name = AQC_GENL_NAME,
+	.version = AQC_GENL_VERSION,
+	.maxattr = AQC_ATTR_MAX,
+	.module = THIS_MODULE,
+	.mcgrps = aqc_genl_mcgrps,
+	.n_mcgrps = ARRAY_SIZE(aqc_genl_mcgrps),
+};
+
+/*
+ * Multicasts the sensor values of the report that was just parsed. Called by the
+ * only writer of the values after the sensor lock is released, so they are stable
+ */
+static void aqc_genl_notify(struct aqc_data *priv, gfp_t gfp)
+{
+	const struct aqc_device_info *info = priv->info;
+	char serial_number[16];
+	struct sk_buff *skb;
+	size_t size;
+	void *hdr;
+	int i;
+
+	if (!genl_has_listeners(&aqc_genl_family, &init_net, 0))
+		return;
+
+	scnprintf(serial_number, sizeof(serial_number), "%05u-%05u", priv->serial_number[0],
+		  priv->serial_number[1]);
+
+	size = nla_total_size(strlen(info->name) + 1) +
+	       nla_total_size(strlen(serial_number) + 1) + 2 * nla_total_size_64bit(sizeof(u64));
+	for (i = 0; i < AQC_SENSOR_TYPES; i++)
+		if (info->num_values[i])
+			size += nla_total_size(info->num_values[i] * sizeof(s32));
+
+	skb = genlmsg_new(size, gfp);
+	if (!skb)
+		return;
+
+	hdr = genlmsg_put(skb, 0, 0, &aqc_genl_family, 0, AQC_CMD_SENSORS);
+	if (!hdr)
+		goto fail;
+
+	if (nla_put_string(skb, AQC_ATTR_KIND, info->name) ||
+	    nla_put_string(skb, AQC_ATTR_SERIAL, serial_number) ||
+	    nla_put_u64_64bit(skb, AQC_ATTR_SEQ, priv->report_seq, AQC_ATTR_PAD) ||
+	    nla_put_u64_64bit(skb, AQC_ATTR_TIMESTAMP, priv->report_time, AQC_ATTR_PAD))
+		goto fail;
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++) {
+		if (!info->num_values[i])
+			continue;
+		if (nla_put(skb, AQC_ATTR_TEMP + i, info->num_values[i] * sizeof(s32),
+			    priv->sensors[i]))
+			goto fail;
+	}
+
+	genlmsg_end(skb, hdr);
+	genlmsg_multicast(&aqc_genl_family, skb, 0, 0, gfp);
+	return;
+
+fail:
+	nlmsg_free(skb);
+}
+
+#if IS_REACHABLE(CONFIG_IIO_KFIFO_BUF)
+
+static bool enable_iio;
+module_param(enable_iio, bool, 0444);
+MODULE_PARM_DESC(enable_iio, "Register an IIO device with buffered sensor readings per device");
+
+/* Sensor types mirrored as IIO channels, with their scale to IIO units */
+static const struct {
+	u8 sensor_type;
+	enum iio_chan_type chan_type;
+	int scale[2];		/* Integer and nano parts */
+} aqc_iio_types[] = {
+	{ AQC_TEMP, IIO_TEMP, { 1, 0 } },
+	{ AQC_SPEED, IIO_ANGL_VEL, { 0, 104719755 } },	/* From RPM to rad/s */
+	{ AQC_POWER, IIO_POWER, { 0, 1000000 } },	/* From uW to mW */
+	{ AQC_VOLTAGE, IIO_VOLTAGE, { 1, 0 } },
+	{ AQC_CURRENT, IIO_CURRENT, { 1, 0 } },
+};
+
+/* Pushed in scans for sensors without a reading */
+#define AQC_IIO_NA			S32_MIN
+
+/* Count of mirrored values of a type. Of the speeds, only the rotational ones are */
+static int aqc_iio_num_values(const struct aqc_device_info *info, int i)
+{
+	int num_values = info->num_values[aqc_iio_types[i].sensor_type];
+
+	if (aqc_iio_types[i].sensor_type != AQC_SPEED)
+		return num_values;
+
+	/* Flow, pressure, water quality and the like follow the fans, if any */
+	if (info->kind == aquastreamult)
+		return min(num_values, info->num_fans + 1);	/* Plus pump speed */
+	return min(num_values, info->num_fans);
+}
+
+static int aqc_iio_read_raw(struct iio_dev *indio_dev, struct iio_chan_spec const *chan,
+			    int *val, int *val2, long mask)
+{
+	struct aqc_data *priv = *(struct aqc_data **)iio_priv(indio_dev);
+	int sensor_type = aqc_iio_types[chan->address].sensor_type;
+	unsigned int seq;
+
+	switch (mask) {
+	case IIO_CHAN_INFO_RAW:
+		if (time_after(jiffies, priv->updated + aqc_sensor_timeout(priv)))
+			return -ENODATA;
+
+		do {
+			seq = read_seqbegin(&priv->sensor_lock);
+			*val = priv->sensors[sensor_type][chan->channel];
+		} while (read_seqretry(&priv->sensor_lock, seq));
+
+		if (*val == -ENODATA)
+			return -ENODATA;
+		return IIO_VAL_INT;
+	case IIO_CHAN_INFO_SCALE:
+		*val = aqc_iio_types[chan->address].scale[0];
+		*val2 = aqc_iio_types[chan->address].scale[1];
+		return IIO_VAL_INT_PLUS_NANO;
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct iio_info aqc_iio_info = {
+	.read_raw = aqc_iio_read_raw,
+};
+
+/*
+ * Registers an IIO device with a channel per mirrored sensor value. Scans are pushed
+ * to its buffer by aqc_iio_push() on each report, so no trigger is needed
+ */
+static int aqc_iio_register(struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	struct device *dev = &priv->hdev->dev;
+	struct iio_chan_spec *channels, *chan;
+	int i, j, ret, num_channels = 0;
+	struct iio_dev *indio_dev;
+	unsigned long *scan_masks;
+
+	if (!enable_iio)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(aqc_iio_types); i++)
+		num_channels += aqc_iio_num_values(info, i);
+
+	indio_dev = devm_iio_device_alloc(dev, sizeof(priv));
+	channels = devm_kcalloc(dev, num_channels + 1, sizeof(*channels), GFP_KERNEL);
+	/* Only scans of all channels are pushed, the IIO core picks the enabled ones out */
+	scan_masks = devm_kcalloc(dev, 2 * BITS_TO_LONGS(num_channels), sizeof(*scan_masks),
+				  GFP_KERNEL);
+	/* Values, followed by the timestamp aligned to 8 bytes */
+	priv->iio_scan = devm_kzalloc(dev, ALIGN(num_channels * sizeof(s32), sizeof(s64)) +
+				      sizeof(s64), GFP_KERNEL);
+	if (!indio_dev || !channels || !scan_masks || !priv->iio_scan)
+		return -ENOMEM;
+
+	chan = channels;
+	for (i = 0; i < ARRAY_SIZE(aqc_iio_types); i++) {
+		for (j = 0; j < aqc_iio_num_values(info, i); j++, chan++) {
+			chan->type = aqc_iio_types[i].chan_type;
+			chan->indexed = 1;
+			chan->channel = j;
+			chan->address = i;
+			chan->scan_index = chan - channels;
+			chan->info_mask_separate = BIT(IIO_CHAN_INFO_RAW);
+			chan->info_mask_shared_by_type = BIT(IIO_CHAN_INFO_SCALE);
+			chan->scan_type.sign = 's';
+			chan->scan_type.realbits = 32;
+			chan->scan_type.storagebits = 32;
+			chan->scan_type.endianness = IIO_CPU;
+		}
+	}
+	*chan = (struct iio_chan_spec)IIO_CHAN_SOFT_TIMESTAMP(num_channels);
+	bitmap_fill(scan_masks, num_channels);
+
+	*(struct aqc_data **)iio_priv(indio_dev) = priv;
+	indio_dev->name = info->name;
+	indio_dev->info = &aqc_iio_info;
+	indio_dev->modes = INDIO_DIRECT_MODE;
+	indio_dev->channels = channels;
+	indio_dev->num_channels = num_channels + 1;
+	indio_dev->available_scan_masks = scan_masks;
+
+#if KERNEL_VERSION(5, 19, 0) <= LINUX_VERSION_CODE
+	ret = devm_iio_kfifo_buffer_setup(dev, indio_dev, NULL);
+#else
+	ret = devm_iio_kfifo_buffer_setup(dev, indio_dev, INDIO_BUFFER_SOFTWARE, NULL);
+#endif
+	if (ret < 0)
+		return ret;
+
+	ret = devm_iio_device_register(dev, indio_dev);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(priv->iio, indio_dev);
+	return 0;
+}
+
+/*
+ * Pushes the sensor values of the report that was just parsed to the IIO buffer.
+ * Called by the only writer of the values after the sensor lock is released
+ */
+static void aqc_iio_push(struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	struct iio_dev *indio_dev = READ_ONCE(priv->iio);
+	s32 *scan = priv->iio_scan;
+	int i, j, num_values;
+	s32 *values;
+
+	if (!indio_dev || !iio_buffer_enabled(indio_dev))
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(aqc_iio_types); i++) {
+		num_values = aqc_iio_num_values(info, i);
+		values = priv->sensors[aqc_iio_types[i].sensor_type];
+		for (j = 0; j < num_values; j++)
+			*scan++ = values[j] == -ENODATA ? AQC_IIO_NA : values[j];
+	}
+
+	iio_push_to_buffers_with_timestamp(indio_dev, priv->iio_scan, iio_get_time_ns(indio_dev));
+}
+
+#else
+
+static int aqc_iio_register(struct aqc_data *priv)
+{
 	return 0;
 }
 
+static void aqc_iio_push(struct aqc_data *priv)
+{
+}
+
+#endif
+
+/* Copies the sensor values to the mappable page, called with sensor_lock held */
+static void aqc_update_sensors_page(struct aqc_data *priv)
+{
+	struct aqc_sensors_page *page = priv->sensors_page;
+	struct aqc_sensors_record *rec;
+
+	if (!page)
+		return;
+
+	rec = &page->record;
+	WRITE_ONCE(page->lock, page->lock + 1);
+	smp_wmb();
+
+	rec->seq = priv->report_seq;
+	rec->timestamp = priv->report_time;
+	memcpy(rec->values, priv->sensors[0], rec->size - sizeof(*rec));
+
+	smp_wmb();
+	WRITE_ONCE(page->lock, page->lock + 1);
+}
+
 /* Read device sensors by manually requesting the sensor report (legacy way) */
 static int aqc_legacy_read(struct aqc_data *priv)
 {
 	int ret, i, sensor_value;
+	unsigned long flags;
+	const struct aqc_device_info *info = priv->info;
 
-	mutex_lock(&priv->mutex);
+	mutex_lock(&priv->status_mutex);
 
-	memset(priv->buffer, 0x00, priv->buffer_size);
-	ret = hid_hw_raw_request(priv->hdev, priv->status_report_id, priv->buffer,
-				 priv->buffer_size, HID_FEATURE_REPORT, HID_REQ_GET_REPORT);
+	memset(priv->status_buffer, 0x00, info->buffer_size);
+	ret = hid_hw_raw_request(priv->hdev, info->status_report_id, priv->status_buffer,
+				 info->buffer_size, HID_FEATURE_REPORT, HID_REQ_GET_REPORT);
 	if (ret < 0)
 		goto unlock_and_return;
 
+	priv->stats.reports[info->status_report_id]++;
+	aqc_raw_push(priv, info->status_report_id, priv->status_buffer, ret);
+
+	write_seqlock_irqsave(&priv->sensor_lock, flags);
+
 	/* Temperature sensor readings */
-	for (i = 0; i < priv->num_temp_sensors; i++) {
-		sensor_value = get_unaligned_le16(priv->buffer + priv->temp_sensor_start_offset +
+	for (i = 0; i < info->num_temp_sensors; i++) {
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  info->temp_sensor_start_offset +
 						  i * AQC_SENSOR_SIZE);
 		if (sensor_value == AQC_SENSOR_NA)
-			priv->temp_input[i] = -ENODATA;
+			priv->sensors[AQC_TEMP][i] = -ENODATA;
 		else
-			priv->temp_input[i] = sensor_value * 10;
+			priv->sensors[AQC_TEMP][i] = sensor_value * 10;
 	}
 
 	/* Serial number */
-	if (priv->serial_number_start_offset) {
-		priv->serial_number[0] = get_unaligned_le16(priv->buffer +
-							    priv->serial_number_start_offset);
+	if (info->serial_number_start_offset) {
+		priv->serial_number[0] = get_unaligned_le16(priv->status_buffer +
+							    info->serial_number_start_offset);
 	}
 
 	/* Firmware version */
-	if (priv->firmware_version_offset) {
+	if (info->firmware_version_offset) {
 		priv->firmware_version =
-		    get_unaligned_le16(priv->buffer + priv->firmware_version_offset);
+		    get_unaligned_le16(priv->status_buffer + info->firmware_version_offset);
 	}
 
 	/* Special-case sensor readings */
-	switch (priv->kind) {
+	switch (info->kind) {
 	case aquastreamxt:
 		/* Read pump speed in RPM */
-		sensor_value = get_unaligned_le16(priv->buffer + priv->fan_sensor_offsets[0]);
-		priv->speed_input[0] = aqc_aquastreamxt_convert_pump_rpm(sensor_value);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  info->fan_sensor_offsets[0]);
+		priv->sensors[AQC_SPEED][0] = aqc_aquastreamxt_convert_pump_rpm(sensor_value);
 
 		/* Read fan speed in RPM, if available */
-		sensor_value = get_unaligned_le16(priv->buffer + AQUASTREAMXT_FAN_STATUS_OFFSET);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  AQUASTREAMXT_FAN_STATUS_OFFSET);
 		if (sensor_value == AQUASTREAMXT_FAN_STOPPED) {
-			priv->speed_input[1] = 0;
+			priv->sensors[AQC_SPEED][1] = 0;
 		} else {
 			sensor_value =
-			    get_unaligned_le16(priv->buffer + priv->fan_sensor_offsets[1]);
-			priv->speed_input[1] = aqc_aquastreamxt_convert_fan_rpm(sensor_value);
+			    get_unaligned_le16(priv->status_buffer + info->fan_sensor_offsets[1]);
+			priv->sensors[AQC_SPEED][1] =
+			    aqc_aquastreamxt_convert_fan_rpm(sensor_value);
 		}
 
 		/* Calculation derived from linear regression */
-		sensor_value = get_unaligned_le16(priv->buffer + AQUASTREAMXT_PUMP_CURR_OFFSET);
-		priv->current_input[0] = DIV_ROUND_CLOSEST(sensor_value * 176, 100) - 52;
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  AQUASTREAMXT_PUMP_CURR_OFFSET);
+		priv->sensors[AQC_CURRENT][0] = DIV_ROUND_CLOSEST(sensor_value * 176, 100) - 52;
 
-		sensor_value = get_unaligned_le16(priv->buffer + AQUASTREAMXT_PUMP_VOLTAGE_OFFSET);
-		priv->voltage_input[0] = DIV_ROUND_CLOSEST(sensor_value * 1000, 61);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  AQUASTREAMXT_PUMP_VOLTAGE_OFFSET);
+		priv->sensors[AQC_VOLTAGE][0] = DIV_ROUND_CLOSEST(sensor_value * 1000, 61);
 
-		sensor_value = get_unaligned_le16(priv->buffer + AQUASTREAMXT_FAN_VOLTAGE_OFFSET);
-		priv->voltage_input[1] = DIV_ROUND_CLOSEST(sensor_value * 1000, 63);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  AQUASTREAMXT_FAN_VOLTAGE_OFFSET);
+		priv->sensors[AQC_VOLTAGE][1] = DIV_ROUND_CLOSEST(sensor_value * 1000, 63);
 		break;
 	case highflow:
 		/* Read flow speed */
-		priv->speed_input[0] = get_unaligned_le16(priv->buffer +
-							  priv->flow_sensors_start_offset);
+		priv->sensors[AQC_SPEED][0] = get_unaligned_le16(priv->status_buffer +
+								 info->flow_sensors_start_offset);
 		break;
 	case poweradjust3:
 		/* Read fan RPM, voltage and current */
-		priv->speed_input[0] = get_unaligned_le16(priv->buffer +
-							  POWERADJUST3_FAN_SPEED_OFFSET);
-		sensor_value = get_unaligned_le16(priv->buffer + POWERADJUST3_FAN_VOLTAGE_OFFSET);
-		priv->voltage_input[0] = sensor_value * 10;
-		priv->current_input[0] = get_unaligned_le16(priv->buffer +
-							    POWERADJUST3_FAN_CURR_OFFSET);
+		priv->sensors[AQC_SPEED][0] = get_unaligned_le16(priv->status_buffer +
+								 POWERADJUST3_FAN_SPEED_OFFSET);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  POWERADJUST3_FAN_VOLTAGE_OFFSET);
+		priv->sensors[AQC_VOLTAGE][0] = sensor_value * 10;
+		priv->sensors[AQC_CURRENT][0] = get_unaligned_le16(priv->status_buffer +
+								   POWERADJUST3_FAN_CURR_OFFSET);
 
 		/* Read flow speed */
-		sensor_value = get_unaligned_le16(priv->buffer + priv->flow_sensors_start_offset);
-		priv->speed_input[1] = DIV_ROUND_CLOSEST(sensor_value, 10);
+		sensor_value = get_unaligned_le16(priv->status_buffer +
+						  info->flow_sensors_start_offset);
+		priv->sensors[AQC_SPEED][1] = DIV_ROUND_CLOSEST(sensor_value, 10);
 		break;
 	default:
 		break;
 	}
 
 	priv->updated = jiffies;
+	priv->report_time = ktime_get_ns();
+	priv->report_seq++;
+	aqc_update_sensors_page(priv);
+
+	write_sequnlock_irqrestore(&priv->sensor_lock, flags);
+
+	aqc_notify_report(priv);
+	aqc_genl_notify(priv, GFP_KERNEL);
+	aqc_iio_push(priv);
+	trace_aqc_sensor_report(priv->hdev, priv->info->name, priv->serial_number,
+				priv->report_seq, priv->info->num_values, priv->sensors[0],
+				priv->num_sensor_values);
 
 unlock_and_return:
-	mutex_unlock(&priv->mutex);
+	mutex_unlock(&priv->status_mutex);
 	return ret;
 }
 
+/* Devices that push sensor reports can't send them more often than they do on their own */
+static unsigned int aqc_update_interval_min(struct aqc_data *priv)
+{
+	return priv->info->status_report_id != 0 ? UPDATE_INTERVAL_MIN : PUSH_REPORT_INTERVAL;
+}
+
+/* Reads sensors of legacy devices in the background, so that sysfs reads never wait */
+static void aqc_legacy_poll_work(struct work_struct *work)
+{
+	struct aqc_data *priv = container_of(to_delayed_work(work), struct aqc_data, poll_work);
+	u64 start = ktime_get_ns();
+
+	/* On failure, the readings become stale and aqc_read() reports that */
+	if (aqc_legacy_read(priv) < 0)
+		priv->stats.legacy_poll_errors++;
+	aqc_hist_add(&priv->stats.legacy_poll, ktime_get_ns() - start);
+
+	schedule_delayed_work(&priv->poll_work, msecs_to_jiffies(READ_ONCE(priv->update_interval)));
+}
+
+/* Maps a hwmon attribute to the sensor values it's read from */
+static int aqc_sensor_type(enum hwmon_sensor_types type, u32 attr)
+{
+	switch (type) {
+	case hwmon_temp:
+		return AQC_TEMP;
+	case hwmon_fan:
+		switch (attr) {
+		case hwmon_fan_input:
+			return AQC_SPEED;
+		case hwmon_fan_min:
+			return AQC_SPEED_MIN;
+		case hwmon_fan_max:
+			return AQC_SPEED_MAX;
+		case hwmon_fan_target:
+			return AQC_SPEED_TARGET;
+		default:
+			return -EOPNOTSUPP;
+		}
+	case hwmon_power:
+		return AQC_POWER;
+	case hwmon_in:
+		return AQC_VOLTAGE;
+	case hwmon_curr:
+		return AQC_CURRENT;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/* Reads a value from the last sensor report, without waiting on control report transfers */
+static int aqc_read_sensor(struct aqc_data *priv, enum hwmon_sensor_types type, u32 attr,
+			   int channel, long *val)
+{
+	int sensor_type = aqc_sensor_type(type, attr);
+	unsigned int seq;
+
+	if (sensor_type < 0)
+		return sensor_type;
+	if (channel >= priv->info->num_values[sensor_type])
+		return -EOPNOTSUPP;
+
+	do {
+		seq = read_seqbegin(&priv->sensor_lock);
+		*val = priv->sensors[sensor_type][channel];
+	} while (read_seqretry(&priv->sensor_lock, seq));
+
+	return 0;
+}
+
 static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		    int channel, long *val)
 {
 	int ret;
 	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
 
-	if (time_after(jiffies, priv->updated + STATUS_UPDATE_INTERVAL)) {
-		if (priv->status_report_id != 0) {
-			/* Legacy devices require manual reads */
-			ret = aqc_legacy_read(priv);
-			if (ret < 0)
-				return -ENODATA;
-		} else {
-			return -ENODATA;
-		}
+	if (type == hwmon_chip) {
+		*val = READ_ONCE(priv->update_interval);
+		return 0;
 	}
 
+	if (time_after(jiffies, priv->updated + aqc_sensor_timeout(priv)))
+		return -ENODATA;
+
 	switch (type) {
 	case hwmon_temp:
 		switch (attr) {
 		case hwmon_temp_input:
-			if (priv->temp_input[channel] == -ENODATA)
+			ret = aqc_read_sensor(priv, type, attr, channel, val);
+			if (ret < 0)
+				return ret;
+			if (*val == -ENODATA)
 				return -ENODATA;
-
-			*val = priv->temp_input[channel];
 			break;
 		case hwmon_temp_offset:
 			ret =
 			    aqc_get_ctrl_val(priv,
-					     priv->temp_ctrl_offset +
+					     info->temp_ctrl_offset +
 					     channel * AQC_SENSOR_SIZE, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
@@ -1345,16 +2842,17 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 	case hwmon_fan:
 		switch (attr) {
 		case hwmon_fan_input:
-			if (priv->speed_input[channel] == -ENODATA)
+			ret = aqc_read_sensor(priv, type, attr, channel, val);
+			if (ret < 0)
+				return ret;
+			if (*val == -ENODATA)
 				return -ENODATA;
-
-			*val = priv->speed_input[channel];
 			break;
 		case hwmon_fan_min:
-			if (priv->kind == aquaero) {
+			if (info->kind == aquaero) {
 				ret =
 				    aqc_get_ctrl_val(priv,
-						     priv->fan_ctrl_offsets[channel] +
+						     info->fan_ctrl_offsets[channel] +
 						     AQUAERO_FAN_CTRL_MIN_RPM_OFFSET,
 						     val, AQC_BE16);
 				if (ret < 0)
@@ -1362,13 +2860,12 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				break;
 			}
 
-			*val = priv->speed_input_min[channel];
-			break;
+			return aqc_read_sensor(priv, type, attr, channel, val);
 		case hwmon_fan_max:
-			if (priv->kind == aquaero) {
+			if (info->kind == aquaero) {
 				ret =
 				    aqc_get_ctrl_val(priv,
-						     priv->fan_ctrl_offsets[channel] +
+						     info->fan_ctrl_offsets[channel] +
 						     AQUAERO_FAN_CTRL_MAX_RPM_OFFSET,
 						     val, AQC_BE16);
 				if (ret < 0)
@@ -1376,13 +2873,11 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				break;
 			}
 
-			*val = priv->speed_input_max[channel];
-			break;
+			return aqc_read_sensor(priv, type, attr, channel, val);
 		case hwmon_fan_target:
-			*val = priv->speed_input_target[channel];
-			break;
+			return aqc_read_sensor(priv, type, attr, channel, val);
 		case hwmon_fan_pulses:
-			ret = aqc_get_ctrl_val(priv, priv->flow_pulses_ctrl_offset, val, AQC_BE16);
+			ret = aqc_get_ctrl_val(priv, info->flow_pulses_ctrl_offset, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
 			break;
@@ -1391,12 +2886,11 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		}
 		break;
 	case hwmon_power:
-		*val = priv->power_input[channel];
-		break;
+		return aqc_read_sensor(priv, type, attr, channel, val);
 	case hwmon_pwm:
 		switch (attr) {
 		case hwmon_pwm_enable:
-			ret = aqc_get_ctrl_val(priv, priv->fan_ctrl_offsets[channel], val, AQC_8);
+			ret = aqc_get_ctrl_val(priv, info->fan_ctrl_offsets[channel], val, AQC_8);
 			if (ret < 0)
 				return ret;
 
@@ -1404,7 +2898,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			*val = *val + 1;
 			break;
 		case hwmon_pwm_input:
-			switch (priv->kind) {
+			switch (info->kind) {
 			case aquaero:
 				ret =
 				    aqc_get_ctrl_val(priv,
@@ -1418,7 +2912,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			case aquastreamxt:
 				if (channel == 0) {
 					ret =
-					    aqc_get_ctrl_val(priv, priv->fan_ctrl_offsets[channel],
+					    aqc_get_ctrl_val(priv, info->fan_ctrl_offsets[channel],
 							     val, AQC_LE16);
 					if (ret < 0)
 						return ret;
@@ -1426,7 +2920,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 					*val = aqc_aquastreamxt_rpm_to_pwm(*val);
 				} else {
 					ret =
-					    aqc_get_ctrl_val(priv, priv->fan_ctrl_offsets[channel],
+					    aqc_get_ctrl_val(priv, info->fan_ctrl_offsets[channel],
 							     val, AQC_8);
 					if (ret < 0)
 						return ret;
@@ -1435,7 +2929,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			default:
 				ret =
 				    aqc_get_ctrl_val(priv,
-						     priv->fan_ctrl_offsets[channel] +
+						     info->fan_ctrl_offsets[channel] +
 						     AQC_FAN_CTRL_PWM_OFFSET, val, AQC_BE16);
 				if (ret < 0)
 					return ret;
@@ -1446,7 +2940,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		case hwmon_pwm_auto_channels_temp:
 			ret =
 			    aqc_get_ctrl_val(priv,
-					     priv->fan_ctrl_offsets[channel] +
+					     info->fan_ctrl_offsets[channel] +
 					     AQC_FAN_CTRL_TEMP_SELECT_OFFSET, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
@@ -1455,7 +2949,7 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			break;
 		case hwmon_pwm_mode:
 			ret = aqc_get_ctrl_val(priv,
-					       priv->fan_ctrl_offsets[channel] +
+					       info->fan_ctrl_offsets[channel] +
 					       AQUAERO_FAN_CTRL_MODE_OFFSET, val, AQC_8);
 			if (ret < 0)
 				return ret;
@@ -1475,11 +2969,8 @@ static int aqc_read(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		}
 		break;
 	case hwmon_in:
-		*val = priv->voltage_input[channel];
-		break;
 	case hwmon_curr:
-		*val = priv->current_input[channel];
-		break;
+		return aqc_read_sensor(priv, type, attr, channel, val);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -1491,40 +2982,41 @@ static int aqc_read_string(struct device *dev, enum hwmon_sensor_types type, u32
 			   int channel, const char **str)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
 
 	/* Number of sensors that are not calculated */
-	int num_non_calc_sensors = priv->num_temp_sensors + priv->num_virtual_temp_sensors;
+	int num_non_calc_sensors = info->num_temp_sensors + info->num_virtual_temp_sensors;
 
 	/* Number of sensors that are native */
-	int num_native_sensors = priv->num_calc_virt_temp_sensors + num_non_calc_sensors;
+	int num_native_sensors = info->num_calc_virt_temp_sensors + num_non_calc_sensors;
 
 	switch (type) {
 	case hwmon_temp:
-		if (channel < priv->num_temp_sensors) {
-			*str = priv->temp_label[channel];
+		if (channel < info->num_temp_sensors) {
+			*str = info->temp_label[channel];
 		} else {
-			if (priv->kind == aquaero && channel >= num_native_sensors)
+			if (info->kind == aquaero && channel >= num_native_sensors)
 				*str =
-				    priv->aquabus_temp_label[channel - num_native_sensors];
-			else if (priv->kind == aquaero && channel >= num_non_calc_sensors)
+				    info->aquabus_temp_label[channel - num_native_sensors];
+			else if (info->kind == aquaero && channel >= num_non_calc_sensors)
 				*str =
-				    priv->calc_virtual_temp_label[channel - num_non_calc_sensors];
+				    info->calc_virtual_temp_label[channel - num_non_calc_sensors];
 			else
-				*str = priv->virtual_temp_label[channel - priv->num_temp_sensors];
+				*str = info->virtual_temp_label[channel - info->num_temp_sensors];
 		}
 
 		break;
 	case hwmon_fan:
-		*str = priv->speed_label[channel];
+		*str = info->speed_label[channel];
 		break;
 	case hwmon_power:
-		*str = priv->power_label[channel];
+		*str = info->power_label[channel];
 		break;
 	case hwmon_in:
-		*str = priv->voltage_label[channel];
+		*str = info->voltage_label[channel];
 		break;
 	case hwmon_curr:
-		*str = priv->current_label[channel];
+		*str = info->current_label[channel];
 		break;
 	default:
 		return -EOPNOTSUPP;
@@ -1543,7 +3035,7 @@ static int aqc_leakshield_send_report(struct aqc_data *priv, int channel, long v
 	u16 checksum;
 	u16 val16;
 
-	if (priv->kind != leakshield)
+	if (priv->info->kind != leakshield)
 		return -EOPNOTSUPP;
 
 	/* Forbid out-of-bounds values */
@@ -1559,6 +3051,9 @@ static int aqc_leakshield_send_report(struct aqc_data *priv, int channel, long v
 	else
 		val16 = (u16)val;
 
+	mutex_lock(&priv->io_mutex);
+	down_write(&priv->ctrl_lock);
+
 	/*
 	 * leakshield_usb_report_template is loaded into priv->buffer during initialization.
 	 * Modify only the requested value (pump RPM or flow) without resetting the other one
@@ -1575,7 +3070,8 @@ static int aqc_leakshield_send_report(struct aqc_data *priv, int channel, long v
 		put_unaligned_be16(val16, priv->buffer + LEAKSHIELD_USB_REPORT_FLOW_OFFSET);
 		break;
 	default:
-		return -EINVAL;
+		ret = -EINVAL;
+		goto unlock_and_return;
 	}
 
 	/* Init and xorout value for CRC-16/USB is 0xffff */
@@ -1588,11 +3084,15 @@ static int aqc_leakshield_send_report(struct aqc_data *priv, int channel, long v
 	intf = to_usb_interface(priv->hdev->dev.parent);
 	usb_dev = interface_to_usbdev(intf);
 	pipe = usb_sndbulkpipe(usb_dev, LEAKSHIELD_USB_REPORT_ENDPOINT);
-	ret = usb_bulk_msg(usb_dev, pipe, priv->buffer, priv->buffer_size, &actual_length, 1000);
+	ret = usb_bulk_msg(usb_dev, pipe, priv->buffer, priv->info->buffer_size, &actual_length,
+			   1000);
 
-	if (actual_length != priv->buffer_size)
-		return -EIO;
+	if (actual_length != priv->info->buffer_size)
+		ret = -EIO;
 
+unlock_and_return:
+	up_write(&priv->ctrl_lock);
+	mutex_unlock(&priv->io_mutex);
 	return ret;
 }
 
@@ -1600,14 +3100,25 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		     long val)
 {
 	int ret, pwm_value, temp_sensor;
+	struct aqc_ctrl_band band;
 	long ctrl_mode;
+	u8 deadband;
 	/* Arrays for setting multiple values at once in the control report */
 	int ctrl_values_offsets[4];
 	long ctrl_values[4];
 	int ctrl_values_types[4];
 	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
 
 	switch (type) {
+	case hwmon_chip:
+		val = clamp_val(val, aqc_update_interval_min(priv), UPDATE_INTERVAL_MAX);
+		WRITE_ONCE(priv->update_interval, val);
+
+		/* Apply the new interval to legacy devices right away */
+		if (info->status_report_id != 0)
+			mod_delayed_work(system_wq, &priv->poll_work, msecs_to_jiffies(val));
+		break;
 	case hwmon_temp:
 		switch (attr) {
 		case hwmon_temp_offset:
@@ -1615,7 +3126,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			val = clamp_val(val, -15000, 15000) / 10;
 			ret =
 			    aqc_set_ctrl_val(priv,
-					     priv->temp_ctrl_offset +
+					     info->temp_ctrl_offset +
 					     channel * AQC_SENSOR_SIZE, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
@@ -1629,7 +3140,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		case hwmon_fan_min:
 			val = clamp_val(val, 0, 15000);
 			ret = aqc_set_ctrl_val(priv,
-					       priv->fan_ctrl_offsets[channel] +
+					       info->fan_ctrl_offsets[channel] +
 					       AQUAERO_FAN_CTRL_MIN_RPM_OFFSET, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
@@ -1637,7 +3148,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 		case hwmon_fan_max:
 			val = clamp_val(val, 0, 15000);
 			ret = aqc_set_ctrl_val(priv,
-					       priv->fan_ctrl_offsets[channel] +
+					       info->fan_ctrl_offsets[channel] +
 					       AQUAERO_FAN_CTRL_MAX_RPM_OFFSET, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
@@ -1646,7 +3157,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			return aqc_leakshield_send_report(priv, channel, val);
 		case hwmon_fan_pulses:
 			val = clamp_val(val, 10, 1000);
-			ret = aqc_set_ctrl_val(priv, priv->flow_pulses_ctrl_offset, val, AQC_BE16);
+			ret = aqc_set_ctrl_val(priv, info->flow_pulses_ctrl_offset, val, AQC_BE16);
 			if (ret < 0)
 				return ret;
 			break;
@@ -1657,14 +3168,14 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 	case hwmon_pwm:
 		switch (attr) {
 		case hwmon_pwm_enable:
-			switch (priv->kind) {
+			switch (info->kind) {
 			case d5next:
 				if (val < 0 || val > 3)
 					return -EINVAL;
 				break;
 			case octo:
 			case quadro:
-				if (val < 0 || val > priv->num_fans + 3)
+				if (val < 0 || val > info->num_fans + 3)
 					return -EINVAL;
 
 				/* Fan can't follow itself */
@@ -1677,7 +3188,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				 */
 				if (val > 3) {
 					ret =
-					    aqc_get_ctrl_val(priv, priv->fan_ctrl_offsets[val - 4],
+					    aqc_get_ctrl_val(priv, info->fan_ctrl_offsets[val - 4],
 							     &ctrl_mode, AQC_8);
 					if (ret < 0)
 						return ret;
@@ -1695,7 +3206,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				/* Set the fan to 100% as we don't control it anymore */
 				ret =
 				    aqc_set_ctrl_val(priv,
-						     priv->fan_ctrl_offsets[channel] +
+						     info->fan_ctrl_offsets[channel] +
 						     AQC_FAN_CTRL_PWM_OFFSET,
 						     aqc_pwm_to_percent(255), AQC_BE16);
 				if (ret < 0)
@@ -1705,7 +3216,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				val--;
 			}
 
-			ret = aqc_set_ctrl_val(priv, priv->fan_ctrl_offsets[channel], val, AQC_8);
+			ret = aqc_set_ctrl_val(priv, info->fan_ctrl_offsets[channel], val, AQC_8);
 			if (ret < 0)
 				return ret;
 			break;
@@ -1713,9 +3224,17 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			if (val < 0 || val > 255)
 				return -EINVAL;
 
-			switch (priv->kind) {
+			/*
+			 * Keep the current value if the new one is within the deadband, so that
+			 * the write is skipped unless it changes anything else
+			 */
+			deadband = READ_ONCE(priv->pwm_deadband[channel]);
+			band.lo = aqc_pwm_to_ctrl_val(priv, channel, max(val - deadband, 0L));
+			band.hi = aqc_pwm_to_ctrl_val(priv, channel, min(val + deadband, 255L));
+
+			switch (info->kind) {
 			case aquaero:
-				pwm_value = aqc_pwm_to_percent(val);
+				pwm_value = aqc_pwm_to_ctrl_val(priv, channel, val);
 				/* Write pwm value to preset corresponding to the channel */
 				ctrl_values_offsets[0] = AQUAERO_CTRL_PRESET_START +
 				    channel * AQUAERO_CTRL_PRESET_SIZE;
@@ -1723,13 +3242,13 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				ctrl_values_types[0] = AQC_BE16;
 
 				/* Write preset number in fan control source */
-				ctrl_values_offsets[1] = priv->fan_ctrl_offsets[channel] +
+				ctrl_values_offsets[1] = info->fan_ctrl_offsets[channel] +
 				    AQUAERO_FAN_CTRL_SRC_OFFSET;
 				ctrl_values[1] = AQUAERO_CTRL_PRESET_ID + channel;
 				ctrl_values_types[1] = AQC_BE16;
 
 				/* Set minimum power to 0 to allow the fan to turn off */
-				ctrl_values_offsets[2] = priv->fan_ctrl_offsets[channel] +
+				ctrl_values_offsets[2] = info->fan_ctrl_offsets[channel] +
 				    AQUAERO_FAN_CTRL_MIN_PWR_OFFSET;
 				ctrl_values[2] = 0;
 				ctrl_values_types[2] = AQC_BE16;
@@ -1738,21 +3257,21 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				 * Set maximum power to 100% to allow the fan to
 				 * reach maximum speed
 				 */
-				ctrl_values_offsets[3] = priv->fan_ctrl_offsets[channel] +
+				ctrl_values_offsets[3] = info->fan_ctrl_offsets[channel] +
 				    AQUAERO_FAN_CTRL_MAX_PWR_OFFSET;
 				ctrl_values[3] = aqc_pwm_to_percent(255);
 				ctrl_values_types[3] = AQC_BE16;
 
-				ret = aqc_set_ctrl_vals(priv, ctrl_values_offsets, ctrl_values,
-							ctrl_values_types, 4);
+				ret = aqc_set_pwm_ctrl_vals(priv, ctrl_values_offsets, ctrl_values,
+							    ctrl_values_types, 4,
+							    deadband ? &band : NULL);
 				if (ret < 0)
 					return ret;
 				break;
 			case aquastreamxt:
 				if (channel == 0) {
-					pwm_value = aqc_aquastreamxt_pwm_to_rpm(val);
-					pwm_value = aqc_aquastreamxt_convert_pump_rpm(pwm_value);
-					ctrl_values_offsets[0] = priv->fan_ctrl_offsets[channel];
+					pwm_value = aqc_pwm_to_ctrl_val(priv, channel, val);
+					ctrl_values_offsets[0] = info->fan_ctrl_offsets[channel];
 					ctrl_values[0] = pwm_value;
 					ctrl_values_types[0] = AQC_LE16;
 
@@ -1761,7 +3280,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 					ctrl_values[1] = AQUASTREAMXT_PUMP_MODE_CTRL_MANUAL;
 					ctrl_values_types[1] = AQC_8;
 				} else {
-					ctrl_values_offsets[0] = priv->fan_ctrl_offsets[channel];
+					ctrl_values_offsets[0] = info->fan_ctrl_offsets[channel];
 					ctrl_values[0] = val;
 					ctrl_values_types[0] = AQC_8;
 
@@ -1770,17 +3289,21 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 					ctrl_values[1] = AQUASTREAMXT_FAN_MODE_CTRL_MANUAL;
 					ctrl_values_types[1] = AQC_8;
 				}
-				ret = aqc_set_ctrl_vals(priv, ctrl_values_offsets, ctrl_values,
-							ctrl_values_types, 2);
+				ret = aqc_set_pwm_ctrl_vals(priv, ctrl_values_offsets, ctrl_values,
+							    ctrl_values_types, 2,
+							    deadband ? &band : NULL);
 				if (ret < 0)
 					return ret;
 				break;
 			default:
-				pwm_value = aqc_pwm_to_percent(val);
-				ret =
-				    aqc_set_ctrl_val(priv,
-						     priv->fan_ctrl_offsets[channel] +
-						     AQC_FAN_CTRL_PWM_OFFSET, pwm_value, AQC_BE16);
+				ctrl_values_offsets[0] = info->fan_ctrl_offsets[channel] +
+				    AQC_FAN_CTRL_PWM_OFFSET;
+				ctrl_values[0] = aqc_pwm_to_ctrl_val(priv, channel, val);
+				ctrl_values_types[0] = AQC_BE16;
+
+				ret = aqc_set_pwm_ctrl_vals(priv, ctrl_values_offsets, ctrl_values,
+							    ctrl_values_types, 1,
+							    deadband ? &band : NULL);
 				if (ret < 0)
 					return ret;
 				break;
@@ -1804,12 +3327,12 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 				return -EINVAL;
 			}
 
-			if (temp_sensor >= priv->num_temp_sensors)
+			if (temp_sensor >= info->num_temp_sensors)
 				return -EINVAL;
 
 			ret =
 			    aqc_set_ctrl_val(priv,
-					     priv->fan_ctrl_offsets[channel] +
+					     info->fan_ctrl_offsets[channel] +
 					     AQC_FAN_CTRL_TEMP_SELECT_OFFSET, temp_sensor,
 					     AQC_BE16);
 			if (ret < 0)
@@ -1828,7 +3351,7 @@ static int aqc_write(struct device *dev, enum hwmon_sensor_types type, u32 attr,
 			}
 
 			ret = aqc_set_ctrl_val(priv,
-					       priv->fan_ctrl_offsets[channel] +
+					       info->fan_ctrl_offsets[channel] +
 					       AQUAERO_FAN_CTRL_MODE_OFFSET, ctrl_mode, AQC_8);
 			if (ret < 0)
 				return ret;
@@ -1981,8 +3504,9 @@ static ssize_t show_auto_temp(struct device *dev, struct device_attribute *attr,
 
 	unsigned long val;
 	int ret = aqc_get_ctrl_val(priv,
-				   priv->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_TEMP_CURVE_START +
-				   point * AQC_SENSOR_SIZE, &val, AQC_BE16);
+				   priv->info->fan_ctrl_offsets[nr] +
+				   AQC_FAN_CTRL_TEMP_CURVE_START + point * AQC_SENSOR_SIZE,
+				   &val, AQC_BE16);
 	if (ret < 0)
 		return -ENODATA;
 
@@ -2003,7 +3527,7 @@ store_auto_temp(struct device *dev, struct device_attribute *attr, const char *b
 		return ret;
 
 	ret = aqc_set_ctrl_val(priv,
-			       priv->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_TEMP_CURVE_START +
+			       priv->info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_TEMP_CURVE_START +
 			       point * AQC_SENSOR_SIZE, val, AQC_BE16);
 	if (ret < 0)
 		return ret;
@@ -2016,45 +3540,125 @@ static ssize_t show_auto_pwm(struct device *dev, struct device_attribute *attr,
 	struct aqc_data *priv = dev_get_drvdata(dev);
 	struct sensor_device_attribute_2 *sattr = to_sensor_dev_attr_2(attr);
 	int nr = sattr->nr;
-	int point = sattr->index;
+	int point = sattr->index;
+
+	unsigned long val;
+	int ret = aqc_get_ctrl_val(priv,
+				   priv->info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
+				   point * AQC_SENSOR_SIZE, &val, AQC_BE16);
+	if (ret < 0)
+		return -ENODATA;
+
+	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+}
+
+static ssize_t
+store_auto_pwm(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute_2 *sattr = to_sensor_dev_attr_2(attr);
+	int nr = sattr->nr;
+	int point = sattr->index;
+	unsigned long val;
+	int pwm_value;
+
+	int ret = kstrtoul(buf, 10, &val);
+
+	if (ret < 0)
+		return ret;
+	if (val > 255)
+		return -EINVAL;
+
+	pwm_value = aqc_pwm_to_percent(val);
+	ret = aqc_set_ctrl_val(priv,
+			       priv->info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
+			       point * AQC_SENSOR_SIZE, pwm_value, AQC_BE16);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+/* Whole temp-PWM curve, as one temp and PWM pair per line */
+static ssize_t show_auto_points(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
+	struct sensor_device_attribute_2 *sattr = to_sensor_dev_attr_2(attr);
+	int nr = sattr->nr;
+	int offsets[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	long values[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	int types[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	int ret, i, len = 0;
+
+	for (i = 0; i < AQC_FAN_CTRL_CURVE_NUM_POINTS; i++) {
+		offsets[i * 2] = info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_TEMP_CURVE_START +
+				 i * AQC_SENSOR_SIZE;
+		offsets[i * 2 + 1] = info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
+				     i * AQC_SENSOR_SIZE;
+		types[i * 2] = AQC_BE16;
+		types[i * 2 + 1] = AQC_BE16;
+	}
 
-	unsigned long val;
-	int ret = aqc_get_ctrl_val(priv,
-				   priv->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
-				   point * AQC_SENSOR_SIZE, &val, AQC_BE16);
+	ret = aqc_get_ctrl_vals(priv, offsets, values, types, AQC_FAN_CTRL_CURVE_NUM_POINTS * 2);
 	if (ret < 0)
 		return -ENODATA;
 
-	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+	for (i = 0; i < AQC_FAN_CTRL_CURVE_NUM_POINTS; i++)
+		len += sysfs_emit_at(buf, len, "%d %d\n", (s16)values[i * 2],
+				     aqc_percent_to_pwm(values[i * 2 + 1]));
+
+	return len;
 }
 
+/* Sets all points of the curve at once, with a single control report write */
 static ssize_t
-store_auto_pwm(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+store_auto_points(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
 	struct sensor_device_attribute_2 *sattr = to_sensor_dev_attr_2(attr);
 	int nr = sattr->nr;
-	int point = sattr->index;
-	unsigned long val;
-	int pwm_value;
-
-	int ret = kstrtoul(buf, 10, &val);
+	int offsets[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	long values[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	int types[AQC_FAN_CTRL_CURVE_NUM_POINTS * 2];
+	unsigned long temp, pwm;
+	const char *pos = buf;
+	int ret, i, n;
+
+	for (i = 0; i < AQC_FAN_CTRL_CURVE_NUM_POINTS; i++) {
+		if (sscanf(pos, "%lu %lu%n", &temp, &pwm, &n) != 2)
+			return -EINVAL;
+		/* Temperatures are read back as signed 16 bit values */
+		if (temp > S16_MAX || pwm > 255)
+			return -EINVAL;
+		pos += n;
+
+		offsets[i * 2] = info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_TEMP_CURVE_START +
+				 i * AQC_SENSOR_SIZE;
+		values[i * 2] = temp;
+		types[i * 2] = AQC_BE16;
+
+		offsets[i * 2 + 1] = info->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
+				     i * AQC_SENSOR_SIZE;
+		values[i * 2 + 1] = aqc_pwm_to_percent(pwm);
+		types[i * 2 + 1] = AQC_BE16;
+	}
 
-	if (ret < 0)
-		return ret;
-	if (val > 255)
+	/* Don't write a curve from a line that has more than the points */
+	if (*skip_spaces(pos))
 		return -EINVAL;
 
-	pwm_value = aqc_pwm_to_percent(val);
-	ret = aqc_set_ctrl_val(priv,
-			       priv->fan_ctrl_offsets[nr] + AQC_FAN_CTRL_PWM_CURVE_START +
-			       point * AQC_SENSOR_SIZE, pwm_value, AQC_BE16);
+	ret = aqc_set_ctrl_vals(priv, offsets, values, types, AQC_FAN_CTRL_CURVE_NUM_POINTS * 2);
 	if (ret < 0)
 		return ret;
 
 	return count;
 }
 
+SENSOR_TEMPLATE_2(temp_auto_points, "temp%d_auto_points",
+		  0644, show_auto_points, store_auto_points, 0, 0);
+
 SENSOR_TEMPLATE_2(temp_auto_point1_pwm, "temp%d_auto_point1_pwm",
 		  0644, show_auto_pwm, store_auto_pwm, 0, 0);
 SENSOR_TEMPLATE_2(temp_auto_point1_temp, "temp%d_auto_point1_temp",
@@ -2174,6 +3778,7 @@ static struct sensor_device_template *aqc_attributes_curve_template[] = {
 	&sensor_dev_template_temp_auto_point15_temp,
 	&sensor_dev_template_temp_auto_point16_pwm,
 	&sensor_dev_template_temp_auto_point16_temp,
+	&sensor_dev_template_temp_auto_points,
 	NULL
 };
 
@@ -2192,7 +3797,7 @@ static ssize_t show_curve_power_min(struct device *dev, struct device_attribute
 
 	unsigned long val;
 	int ret = aqc_get_ctrl_val(priv,
-				   priv->fan_curve_min_power_offsets[index], &val, AQC_BE16);
+				   priv->info->fan_curve_min_power_offsets[index], &val, AQC_BE16);
 	if (ret < 0)
 		return -ENODATA;
 
@@ -2216,7 +3821,8 @@ store_curve_power_min(struct device *dev, struct device_attribute *attr, const c
 		return -EINVAL;
 
 	pwm_value = aqc_pwm_to_percent(val);
-	ret = aqc_set_ctrl_val(priv, priv->fan_curve_min_power_offsets[index], pwm_value, AQC_BE16);
+	ret = aqc_set_ctrl_val(priv, priv->info->fan_curve_min_power_offsets[index], pwm_value,
+			       AQC_BE16);
 	if (ret < 0)
 		return ret;
 
@@ -2232,206 +3838,619 @@ static ssize_t show_curve_power_max(struct device *dev, struct device_attribute
 
 	unsigned long val;
 	int ret = aqc_get_ctrl_val(priv,
-				   priv->fan_curve_max_power_offsets[index], &val, AQC_BE16);
+				   priv->info->fan_curve_max_power_offsets[index], &val, AQC_BE16);
+	if (ret < 0)
+		return -ENODATA;
+
+	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+}
+
+static ssize_t
+store_curve_power_max(struct device *dev, struct device_attribute *attr, const char *buf,
+		      size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index;
+	unsigned long val;
+	int ret = kstrtoul(buf, 10, &val);
+	int pwm_value;
+
+	if (ret < 0)
+		return ret;
+	if (val > 255)
+		return -EINVAL;
+
+	pwm_value = aqc_pwm_to_percent(val);
+	ret = aqc_set_ctrl_val(priv, priv->info->fan_curve_max_power_offsets[index], pwm_value,
+			       AQC_BE16);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_curve_power_fallback(struct device *dev, struct device_attribute *attr,
+					 char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index;
+
+	unsigned long val;
+	int ret = aqc_get_ctrl_val(priv,
+				   priv->info->fan_curve_fallback_power_offsets[index], &val,
+				   AQC_BE16);
+	if (ret < 0)
+		return -ENODATA;
+
+	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+}
+
+static ssize_t
+store_curve_power_fallback(struct device *dev, struct device_attribute *attr, const char *buf,
+			   size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index;
+	unsigned long val;
+	int ret = kstrtoul(buf, 10, &val);
+	int pwm_value;
+
+	if (ret < 0)
+		return ret;
+	if (val > 255)
+		return -EINVAL;
+
+	pwm_value = aqc_pwm_to_percent(val);
+	ret = aqc_set_ctrl_val(priv,
+			       priv->info->fan_curve_fallback_power_offsets[index], pwm_value,
+			       AQC_BE16);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_curve_start_boost(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index, ret;
+	unsigned long val;
+
+	ret = aqc_get_ctrl_val(priv,
+			       priv->info->fan_curve_hold_start_offsets[index], &val, AQC_8);
+	if (ret < 0)
+		return -ENODATA;
+
+	return sprintf(buf, "%d\n", aqc_get_bit_at_pos(val, FAN_CURVE_START_BOOST_BIT_POS));
+}
+
+static ssize_t
+store_curve_start_boost(struct device *dev, struct device_attribute *attr, const char *buf,
+			size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index;
+	unsigned long val, new_val;
+	int ret = kstrtoul(buf, 10, &val);
+
+	if (ret < 0)
+		return ret;
+	if (val > 2)
+		return -EINVAL;
+
+	ret = aqc_get_ctrl_val(priv, info->fan_curve_hold_start_offsets[index], &new_val, AQC_8);
+	if (ret < 0)
+		return ret;
+
+	new_val = aqc_set_bit_at_pos(new_val, FAN_CURVE_START_BOOST_BIT_POS, val);
+
+	ret = aqc_set_ctrl_val(priv, info->fan_curve_hold_start_offsets[index], new_val, AQC_8);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_curve_power_hold_min(struct device *dev, struct device_attribute *attr,
+					 char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index, ret;
+	unsigned long val;
+
+	ret = aqc_get_ctrl_val(priv,
+			       priv->info->fan_curve_hold_start_offsets[index], &val, AQC_8);
 	if (ret < 0)
 		return -ENODATA;
 
-	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+	return sprintf(buf, "%d\n", aqc_get_bit_at_pos(val, FAN_CURVE_HOLD_MIN_POWER_BIT_POS));
+}
+
+static ssize_t
+store_curve_power_hold_min(struct device *dev, struct device_attribute *attr, const char *buf,
+			   size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	const struct aqc_device_info *info = priv->info;
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	int index = sattr->index;
+	unsigned long val, new_val;
+	int ret = kstrtoul(buf, 10, &val);
+
+	if (ret < 0)
+		return ret;
+	if (val > 2)
+		return -EINVAL;
+
+	ret = aqc_get_ctrl_val(priv, info->fan_curve_hold_start_offsets[index], &new_val, AQC_8);
+	if (ret < 0)
+		return ret;
+
+	new_val = aqc_set_bit_at_pos(new_val, FAN_CURVE_HOLD_MIN_POWER_BIT_POS, val);
+
+	ret = aqc_set_ctrl_val(priv, info->fan_curve_hold_start_offsets[index], new_val, AQC_8);
+	if (ret < 0)
+		return ret;
+
+	return count;
+}
+
+SENSOR_TEMPLATE(curve_power_min, "curve%d_power_min",
+		0644, show_curve_power_min, store_curve_power_min, 0);
+SENSOR_TEMPLATE(curve_power_max, "curve%d_power_max",
+		0644, show_curve_power_max, store_curve_power_max, 0);
+SENSOR_TEMPLATE(curve_power_fallback, "curve%d_power_fallback",
+		0644, show_curve_power_fallback, store_curve_power_fallback, 0);
+SENSOR_TEMPLATE(curve_start_boost, "curve%d_start_boost",
+		0644, show_curve_start_boost, store_curve_start_boost, 0);
+SENSOR_TEMPLATE(curve_power_hold_min, "curve%d_power_hold_min",
+		0644, show_curve_power_hold_min, store_curve_power_hold_min, 0);
+
+static umode_t aqc_params_is_visible(struct kobject *kobj, struct attribute *attr, int index)
+{
+	/*
+	 * Pump channel on the D5 Next does not support the last two features,
+	 * "start boost" and "hold min power". Every other fan curve supports
+	 * all parameters.
+	 */
+	struct device *dev = kobj_to_dev(kobj);
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	int nr = index % 5;
+
+	if (priv->info->kind == d5next && nr > 2)
+		return 0;
+
+	return attr->mode;
+}
+
+static ssize_t show_pwm_deadband(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+
+	return sprintf(buf, "%u\n", READ_ONCE(priv->pwm_deadband[sattr->index]));
+}
+
+static ssize_t store_pwm_deadband(struct device *dev, struct device_attribute *attr,
+				  const char *buf, size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
+	u8 val;
+	int ret = kstrtou8(buf, 10, &val);
+
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(priv->pwm_deadband[sattr->index], val);
+
+	return count;
+}
+
+SENSOR_TEMPLATE(pwm_deadband, "pwm%d_deadband", 0644, show_pwm_deadband, store_pwm_deadband, 0);
+
+static struct sensor_device_template *aqc_attributes_pwm_template[] = {
+	&sensor_dev_template_pwm_deadband,
+	NULL
+};
+
+static const struct sensor_template_group aqc_pwm_template_group = {
+	.templates = aqc_attributes_pwm_template,
+	.base = 1,
+};
+
+static struct sensor_device_template *aqc_attributes_params_template[] = {
+	&sensor_dev_template_curve_power_min,
+	&sensor_dev_template_curve_power_max,
+	&sensor_dev_template_curve_power_fallback,
+	&sensor_dev_template_curve_start_boost,
+	&sensor_dev_template_curve_power_hold_min,
+	NULL
+};
+
+static const struct sensor_template_group aqc_curve_params_template_group = {
+	.templates = aqc_attributes_params_template,
+	.is_visible = aqc_params_is_visible,
+	.base = 1,
+};
+
+/* Control report write settings */
+static ssize_t ctrl_write_delay_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(priv->ctrl_write_delay));
+}
+
+static ssize_t ctrl_write_delay_store(struct device *dev, struct device_attribute *attr,
+				      const char *buf, size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret = kstrtouint(buf, 10, &val);
+
+	if (ret < 0)
+		return ret;
+	if (val > CTRL_WRITE_DELAY_MAX)
+		return -EINVAL;
+
+	down_write(&priv->ctrl_lock);
+	WRITE_ONCE(priv->ctrl_write_delay, val);
+	up_write(&priv->ctrl_lock);
+
+	/* Don't hold back writes that were deferred before the change */
+	if (val == 0)
+		flush_delayed_work(&priv->ctrl_write_work);
+
+	return count;
+}
+
+static ssize_t ctrl_write_status_show(struct device *dev, struct device_attribute *attr,
+				      char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(priv->ctrl_write_status));
+}
+
+static ssize_t ctrl_async_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(priv->ctrl_async));
 }
 
-static ssize_t
-store_curve_power_max(struct device *dev, struct device_attribute *attr, const char *buf,
-		      size_t count)
+static ssize_t ctrl_async_store(struct device *dev, struct device_attribute *attr,
+				const char *buf, size_t count)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index;
-	unsigned long val;
-	int ret = kstrtoul(buf, 10, &val);
-	int pwm_value;
+	bool val;
+	int ret = kstrtobool(buf, &val);
 
 	if (ret < 0)
 		return ret;
-	if (val > 255)
-		return -EINVAL;
 
-	pwm_value = aqc_pwm_to_percent(val);
-	ret = aqc_set_ctrl_val(priv, priv->fan_curve_max_power_offsets[index], pwm_value, AQC_BE16);
-	if (ret < 0)
-		return ret;
+	down_write(&priv->ctrl_lock);
+	WRITE_ONCE(priv->ctrl_async, val);
+	up_write(&priv->ctrl_lock);
+
+	/* Writes return with their result again, so don't leave queued ones behind */
+	if (!val)
+		flush_delayed_work(&priv->ctrl_write_work);
 
 	return count;
 }
 
-static ssize_t show_curve_power_fallback(struct device *dev, struct device_attribute *attr,
-					 char *buf)
+/* Sends queued writes right away and returns the result of the last write as the error */
+static ssize_t ctrl_sync_store(struct device *dev, struct device_attribute *attr,
+			       const char *buf, size_t count)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index;
+	bool val;
+	int ret = kstrtobool(buf, &val);
 
-	unsigned long val;
-	int ret = aqc_get_ctrl_val(priv,
-				   priv->fan_curve_fallback_power_offsets[index], &val, AQC_BE16);
 	if (ret < 0)
-		return -ENODATA;
+		return ret;
+	if (!val)
+		return count;
 
-	return sprintf(buf, "%d\n", aqc_percent_to_pwm(val));
+	mutex_lock(&priv->io_mutex);
+	ret = aqc_ctrl_flush(priv);
+	mutex_unlock(&priv->io_mutex);
+
+	return ret < 0 ? ret : count;
 }
 
-static ssize_t
-store_curve_power_fallback(struct device *dev, struct device_attribute *attr, const char *buf,
-			   size_t count)
+static ssize_t ctrl_volatile_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index;
-	unsigned long val;
-	int ret = kstrtoul(buf, 10, &val);
-	int pwm_value;
 
-	if (ret < 0)
-		return ret;
-	if (val > 255)
-		return -EINVAL;
+	return sprintf(buf, "%d\n", READ_ONCE(priv->ctrl_volatile));
+}
+
+static ssize_t ctrl_volatile_store(struct device *dev, struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	bool val;
+	int ret = kstrtobool(buf, &val);
 
-	pwm_value = aqc_pwm_to_percent(val);
-	ret = aqc_set_ctrl_val(priv,
-			       priv->fan_curve_fallback_power_offsets[index], pwm_value, AQC_BE16);
 	if (ret < 0)
 		return ret;
 
-	return count;
+	/* Writes deferred in the previous mode are sent as in that mode */
+	flush_delayed_work(&priv->ctrl_write_work);
+
+	mutex_lock(&priv->io_mutex);
+	WRITE_ONCE(priv->ctrl_volatile, val);
+
+	/* Leaving volatile mode saves what was written in it */
+	if (!val && priv->ctrl_unsaved)
+		ret = aqc_ctrl_commit(priv);
+	mutex_unlock(&priv->io_mutex);
+
+	return ret < 0 ? ret : count;
 }
 
-static ssize_t show_curve_start_boost(struct device *dev, struct device_attribute *attr, char *buf)
+static ssize_t ctrl_commit_store(struct device *dev, struct device_attribute *attr,
+				 const char *buf, size_t count)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index, ret;
-	unsigned long val;
+	bool val;
+	int ret = kstrtobool(buf, &val);
 
-	ret = aqc_get_ctrl_val(priv,
-			       priv->fan_curve_hold_start_offsets[index], &val, AQC_8);
 	if (ret < 0)
-		return -ENODATA;
+		return ret;
+	if (!val)
+		return count;
 
-	return sprintf(buf, "%d\n", aqc_get_bit_at_pos(val, FAN_CURVE_START_BOOST_BIT_POS));
+	/* Send deferred writes first, so that they are saved as well */
+	flush_delayed_work(&priv->ctrl_write_work);
+
+	mutex_lock(&priv->io_mutex);
+	ret = aqc_ctrl_commit(priv);
+	mutex_unlock(&priv->io_mutex);
+
+	return ret < 0 ? ret : count;
 }
 
-static ssize_t
-store_curve_start_boost(struct device *dev, struct device_attribute *attr, const char *buf,
-			size_t count)
+static ssize_t ctrl_commit_interval_show(struct device *dev, struct device_attribute *attr,
+					 char *buf)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index;
-	unsigned long val, new_val;
-	int ret = kstrtoul(buf, 10, &val);
+
+	return sprintf(buf, "%u\n", READ_ONCE(priv->ctrl_commit_interval));
+}
+
+static ssize_t ctrl_commit_interval_store(struct device *dev, struct device_attribute *attr,
+					  const char *buf, size_t count)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret = kstrtouint(buf, 10, &val);
 
 	if (ret < 0)
 		return ret;
-	if (val > 2)
+	if (val > CTRL_COMMIT_INTERVAL_MAX)
 		return -EINVAL;
 
-	ret = aqc_get_ctrl_val(priv, priv->fan_curve_hold_start_offsets[index], &new_val, AQC_8);
-	if (ret < 0)
-		return ret;
+	mutex_lock(&priv->io_mutex);
+	WRITE_ONCE(priv->ctrl_commit_interval, val);
+	if (val && priv->ctrl_unsaved)
+		mod_delayed_work(priv->ctrl_wq, &priv->ctrl_commit_work, msecs_to_jiffies(val));
+	mutex_unlock(&priv->io_mutex);
 
-	new_val = aqc_set_bit_at_pos(new_val, FAN_CURVE_START_BOOST_BIT_POS, val);
+	return count;
+}
 
-	ret = aqc_set_ctrl_val(priv, priv->fan_curve_hold_start_offsets[index], new_val, AQC_8);
-	if (ret < 0)
-		return ret;
+static ssize_t ctrl_report_delay_show(struct device *dev, struct device_attribute *attr,
+				      char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
 
-	return count;
+	return sprintf(buf, "%u\n", READ_ONCE(priv->ctrl_delay));
 }
 
-static ssize_t show_curve_power_hold_min(struct device *dev, struct device_attribute *attr,
-					 char *buf)
+static ssize_t ctrl_report_delay_min_show(struct device *dev, struct device_attribute *attr,
+					  char *buf)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index, ret;
-	unsigned long val;
 
-	ret = aqc_get_ctrl_val(priv,
-			       priv->fan_curve_hold_start_offsets[index], &val, AQC_8);
-	if (ret < 0)
-		return -ENODATA;
+	return sprintf(buf, "%u\n", READ_ONCE(priv->ctrl_delay_min));
+}
 
-	return sprintf(buf, "%d\n", aqc_get_bit_at_pos(val, FAN_CURVE_HOLD_MIN_POWER_BIT_POS));
+static ssize_t ctrl_report_delay_max_show(struct device *dev, struct device_attribute *attr,
+					  char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(priv->ctrl_delay_max));
 }
 
-static ssize_t
-store_curve_power_hold_min(struct device *dev, struct device_attribute *attr, const char *buf,
-			   size_t count)
+/* Sets the floor or ceiling of the adaptive delay and keeps the delay within them */
+static ssize_t aqc_store_ctrl_report_delay_limit(struct device *dev, const char *buf,
+						 size_t count, bool ceiling)
 {
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	struct sensor_device_attribute *sattr = to_sensor_dev_attr(attr);
-	int index = sattr->index;
-	unsigned long val, new_val;
-	int ret = kstrtoul(buf, 10, &val);
+	unsigned int val;
+	int ret = kstrtouint(buf, 10, &val);
 
 	if (ret < 0)
 		return ret;
-	if (val > 2)
+	if (val > CTRL_REPORT_DELAY_MAX)
 		return -EINVAL;
 
-	ret = aqc_get_ctrl_val(priv, priv->fan_curve_hold_start_offsets[index], &new_val, AQC_8);
-	if (ret < 0)
-		return ret;
+	mutex_lock(&priv->io_mutex);
+	if (ceiling ? val < priv->ctrl_delay_min : val > priv->ctrl_delay_max) {
+		ret = -EINVAL;
+		goto unlock_and_return;
+	}
 
-	new_val = aqc_set_bit_at_pos(new_val, FAN_CURVE_HOLD_MIN_POWER_BIT_POS, val);
+	/* A new floor is calibrated again from there */
+	if (ceiling)
+		priv->ctrl_delay_max = val;
+	else
+		priv->ctrl_delay_min = val;
+	priv->ctrl_delay_floor = clamp(ceiling ? priv->ctrl_delay_floor : val,
+				       priv->ctrl_delay_min, priv->ctrl_delay_max);
+	priv->ctrl_delay = clamp(priv->ctrl_delay, priv->ctrl_delay_floor, priv->ctrl_delay_max);
 
-	ret = aqc_set_ctrl_val(priv, priv->fan_curve_hold_start_offsets[index], new_val, AQC_8);
-	if (ret < 0)
-		return ret;
+unlock_and_return:
+	mutex_unlock(&priv->io_mutex);
+	return ret < 0 ? ret : count;
+}
 
-	return count;
+static ssize_t ctrl_report_delay_min_store(struct device *dev, struct device_attribute *attr,
+					   const char *buf, size_t count)
+{
+	return aqc_store_ctrl_report_delay_limit(dev, buf, count, false);
 }
 
-SENSOR_TEMPLATE(curve_power_min, "curve%d_power_min",
-		0644, show_curve_power_min, store_curve_power_min, 0);
-SENSOR_TEMPLATE(curve_power_max, "curve%d_power_max",
-		0644, show_curve_power_max, store_curve_power_max, 0);
-SENSOR_TEMPLATE(curve_power_fallback, "curve%d_power_fallback",
-		0644, show_curve_power_fallback, store_curve_power_fallback, 0);
-SENSOR_TEMPLATE(curve_start_boost, "curve%d_start_boost",
-		0644, show_curve_start_boost, store_curve_start_boost, 0);
-SENSOR_TEMPLATE(curve_power_hold_min, "curve%d_power_hold_min",
-		0644, show_curve_power_hold_min, store_curve_power_hold_min, 0);
+static ssize_t ctrl_report_delay_max_store(struct device *dev, struct device_attribute *attr,
+					   const char *buf, size_t count)
+{
+	return aqc_store_ctrl_report_delay_limit(dev, buf, count, true);
+}
 
-static umode_t aqc_params_is_visible(struct kobject *kobj, struct attribute *attr, int index)
+static DEVICE_ATTR_RW(ctrl_write_delay);
+static DEVICE_ATTR_RO(ctrl_write_status);
+static DEVICE_ATTR_RW(ctrl_async);
+static DEVICE_ATTR_WO(ctrl_sync);
+static DEVICE_ATTR_RO(ctrl_report_delay);
+static DEVICE_ATTR_RW(ctrl_report_delay_min);
+static DEVICE_ATTR_RW(ctrl_report_delay_max);
+static DEVICE_ATTR_RW(ctrl_volatile);
+static DEVICE_ATTR_WO(ctrl_commit);
+static DEVICE_ATTR_RW(ctrl_commit_interval);
+
+static struct attribute *aqc_ctrl_attrs[] = {
+	&dev_attr_ctrl_write_delay.attr,
+	&dev_attr_ctrl_write_status.attr,
+	&dev_attr_ctrl_async.attr,
+	&dev_attr_ctrl_sync.attr,
+	&dev_attr_ctrl_volatile.attr,
+	&dev_attr_ctrl_commit.attr,
+	&dev_attr_ctrl_commit_interval.attr,
+	&dev_attr_ctrl_report_delay.attr,
+	&dev_attr_ctrl_report_delay_min.attr,
+	&dev_attr_ctrl_report_delay_max.attr,
+	NULL
+};
+
+static umode_t aqc_ctrl_is_visible(struct kobject *kobj, struct attribute *attr, int index)
 {
-	/*
-	 * Pump channel on the D5 Next does not support the last two features,
-	 * "start boost" and "hold min power". Every other fan curve supports
-	 * all parameters.
-	 */
 	struct device *dev = kobj_to_dev(kobj);
 	struct aqc_data *priv = dev_get_drvdata(dev);
-	int nr = index % 5;
+	const struct aqc_device_info *info = priv->info;
+
+	/* Only for devices that are configured through control reports */
+	if (!info->fan_ctrl_offsets && !info->temp_ctrl_offset)
+		return 0;
 
-	if (priv->kind == d5next && nr > 2)
+	/* Only for devices that need time between control report operations */
+	if ((attr == &dev_attr_ctrl_report_delay.attr ||
+	     attr == &dev_attr_ctrl_report_delay_min.attr ||
+	     attr == &dev_attr_ctrl_report_delay_max.attr) && !info->ctrl_report_delay)
 		return 0;
 
 	return attr->mode;
 }
 
-static struct sensor_device_template *aqc_attributes_params_template[] = {
-	&sensor_dev_template_curve_power_min,
-	&sensor_dev_template_curve_power_max,
-	&sensor_dev_template_curve_power_fallback,
-	&sensor_dev_template_curve_start_boost,
-	&sensor_dev_template_curve_power_hold_min,
+static const struct attribute_group aqc_ctrl_group = {
+	.attrs = aqc_ctrl_attrs,
+	.is_visible = aqc_ctrl_is_visible,
+};
+
+/* Sensor report status */
+static ssize_t staleness_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", jiffies_to_msecs(jiffies - READ_ONCE(priv->updated)));
+}
+
+static ssize_t sequence_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	struct aqc_data *priv = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%lu\n", READ_ONCE(priv->report_seq));
+}
+
+/* Returns all sensor values from the last report at once, so that they are consistent */
+#if KERNEL_VERSION(6, 16, 0) <= LINUX_VERSION_CODE
+static ssize_t sensors_read(struct file *filp, struct kobject *kobj,
+			    const struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+#else
+static ssize_t sensors_read(struct file *filp, struct kobject *kobj,
+			    struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+#endif
+{
+	struct aqc_data *priv = dev_get_drvdata(kobj_to_dev(kobj));
+	const struct aqc_device_info *info = priv->info;
+	struct aqc_sensors_record *rec;
+	int i, num_values = 0;
+	unsigned int seq;
+	size_t size;
+	ssize_t ret;
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++)
+		num_values += info->num_values[i];
+
+	size = struct_size(rec, values, num_values);
+	rec = kzalloc(size, GFP_KERNEL);
+	if (!rec)
+		return -ENOMEM;
+
+	rec->version = AQC_SENSORS_VERSION;
+	rec->size = size;
+	memcpy(rec->num_values, info->num_values, sizeof(info->num_values));
+
+	/* The values of all types are allocated in one piece, starting at sensors[0] */
+	do {
+		seq = read_seqbegin(&priv->sensor_lock);
+		rec->seq = priv->report_seq;
+		rec->timestamp = priv->report_time;
+		memcpy(rec->values, priv->sensors[0], num_values * sizeof(*rec->values));
+	} while (read_seqretry(&priv->sensor_lock, seq));
+
+	if (time_after(jiffies, priv->updated + aqc_sensor_timeout(priv)))
+		ret = -ENODATA;
+	else
+		ret = memory_read_from_buffer(buf, count, &off, rec, size);
+
+	kfree(rec);
+	return ret;
+}
+
+static DEVICE_ATTR_RO(staleness);
+static DEVICE_ATTR_RO(sequence);
+static BIN_ATTR_RO(sensors, 0);
+
+static struct attribute *aqc_status_attrs[] = {
+	&dev_attr_staleness.attr,
+	&dev_attr_sequence.attr,
 	NULL
 };
 
-static const struct sensor_template_group aqc_curve_params_template_group = {
-	.templates = aqc_attributes_params_template,
-	.is_visible = aqc_params_is_visible,
-	.base = 1,
+#if KERNEL_VERSION(6, 16, 0) <= LINUX_VERSION_CODE
+static const struct bin_attribute *const aqc_status_bin_attrs[] = {
+#else
+static struct bin_attribute *aqc_status_bin_attrs[] = {
+#endif
+	&bin_attr_sensors,
+	NULL
+};
+
+static const struct attribute_group aqc_status_group = {
+	.attrs = aqc_status_attrs,
+	.bin_attrs = aqc_status_bin_attrs,
 };
 
 static const struct hwmon_ops aqc_hwmon_ops = {
@@ -2441,186 +4460,180 @@ static const struct hwmon_ops aqc_hwmon_ops = {
 	.write = aqc_write
 };
 
-static const struct hwmon_channel_info * const aqc_info[] = {
-	HWMON_CHANNEL_INFO(temp,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL | HWMON_T_OFFSET,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL,
-			   HWMON_T_INPUT | HWMON_T_LABEL),
-	HWMON_CHANNEL_INFO(fan,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_MIN | HWMON_F_MAX |
-			   HWMON_F_TARGET,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_MIN | HWMON_F_MAX,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_MIN | HWMON_F_MAX,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_MIN | HWMON_F_MAX,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_PULSES,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_PULSES,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL,
-			   HWMON_F_INPUT | HWMON_F_LABEL),
-	HWMON_CHANNEL_INFO(power,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL,
-			   HWMON_P_INPUT | HWMON_P_LABEL),
-	HWMON_CHANNEL_INFO(pwm,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP |
-			   HWMON_PWM_MODE,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP |
-			   HWMON_PWM_MODE,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP |
-			   HWMON_PWM_MODE,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP |
-			   HWMON_PWM_MODE,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP,
-			   HWMON_PWM_INPUT | HWMON_PWM_ENABLE | HWMON_PWM_AUTO_CHANNELS_TEMP),
-	HWMON_CHANNEL_INFO(in,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL,
-			   HWMON_I_INPUT | HWMON_I_LABEL),
-	HWMON_CHANNEL_INFO(curr,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL,
-			   HWMON_C_INPUT | HWMON_C_LABEL),
-	NULL
+/* Sensor types in the order they are registered, chip first */
+static const enum hwmon_sensor_types aqc_hwmon_types[] = {
+	hwmon_chip, hwmon_temp, hwmon_fan, hwmon_power, hwmon_pwm, hwmon_in, hwmon_curr
 };
 
-static const struct hwmon_chip_info aqc_chip_info = {
-	.ops = &aqc_hwmon_ops,
-	.info = aqc_info,
-};
+static int aqc_num_channels(const struct aqc_data *priv, enum hwmon_sensor_types type)
+{
+	const struct aqc_device_info *info = priv->info;
 
-static int aqc_raw_event(struct hid_device *hdev, struct hid_report *report, u8 *data, int size)
+	switch (type) {
+	case hwmon_chip:
+		return 1;
+	case hwmon_temp:
+		return info->num_values[AQC_TEMP];
+	case hwmon_fan:
+		return info->num_values[AQC_SPEED];
+	case hwmon_power:
+		return info->num_values[AQC_POWER];
+	case hwmon_pwm:
+		return info->fan_ctrl_offsets ? info->num_fans : 0;
+	case hwmon_in:
+		return info->num_values[AQC_VOLTAGE];
+	case hwmon_curr:
+		return info->num_values[AQC_CURRENT];
+	default:
+		return 0;
+	}
+}
+
+/* Attributes of a channel, from the sensor counts and control report offsets of the device */
+static u32 aqc_channel_config(const struct aqc_data *priv, enum hwmon_sensor_types type,
+			      int channel)
 {
-	int i, j;
-	s16 sensor_value;
-	struct aqc_data *priv;
+	const struct aqc_device_info *info = priv->info;
+	u32 config;
 
-	if (report->id != STATUS_REPORT_ID)
+	switch (type) {
+	case hwmon_chip:
+		return HWMON_C_UPDATE_INTERVAL;
+	case hwmon_temp:
+		config = HWMON_T_INPUT | HWMON_T_LABEL;
+		if (info->temp_ctrl_offset && channel < info->num_temp_sensors)
+			config |= HWMON_T_OFFSET;
+		return config;
+	case hwmon_fan:
+		config = HWMON_F_INPUT | HWMON_F_LABEL;
+		if (channel < info->num_values[AQC_SPEED_MIN])
+			config |= HWMON_F_MIN;
+		if (channel < info->num_values[AQC_SPEED_TARGET])
+			config |= HWMON_F_TARGET;
+		if (channel < info->num_values[AQC_SPEED_MAX])
+			config |= HWMON_F_MAX;
+		if (channel < info->num_fans)
+			config |= info->fan_ctrl_config;
+		/* The first flow sensor comes right after the fans */
+		if (info->flow_pulses_ctrl_offset && channel == info->num_fans)
+			config |= HWMON_F_PULSES;
+		return config;
+	case hwmon_power:
+		return HWMON_P_INPUT | HWMON_P_LABEL;
+	case hwmon_pwm:
+		config = info->pwm_config;
+		/* Only known from the hardware version, aquaero_hw_kind is unknown elsewhere */
+		if ((priv->aquaero_hw_kind == aquaero5 && channel == 3) ||
+		    priv->aquaero_hw_kind == aquaero6)
+			config |= HWMON_PWM_MODE;
+		return config;
+	case hwmon_in:
+		return HWMON_I_INPUT | HWMON_I_LABEL;
+	case hwmon_curr:
+		return HWMON_C_INPUT | HWMON_C_LABEL;
+	default:
 		return 0;
+	}
+}
 
-	priv = hid_get_drvdata(hdev);
+/* Builds hwmon chip info declaring only the channels and attributes of the device */
+static const struct hwmon_chip_info *aqc_build_chip_info(struct aqc_data *priv)
+{
+	struct device *dev = &priv->hdev->dev;
+	const struct hwmon_channel_info **info;
+	struct hwmon_channel_info *channels;
+	struct hwmon_chip_info *chip_info;
+	int i, channel, num_channels, num_info = 0;
+	u32 *config;
+
+	chip_info = devm_kzalloc(dev, sizeof(*chip_info), GFP_KERNEL);
+	info = devm_kcalloc(dev, ARRAY_SIZE(aqc_hwmon_types) + 1, sizeof(*info), GFP_KERNEL);
+	channels = devm_kcalloc(dev, ARRAY_SIZE(aqc_hwmon_types), sizeof(*channels), GFP_KERNEL);
+	if (!chip_info || !info || !channels)
+		return ERR_PTR(-ENOMEM);
 
-	/* Info provided with every report */
-	priv->serial_number[0] = get_unaligned_be16(data + priv->serial_number_start_offset);
-	priv->serial_number[1] =
-	    get_unaligned_be16(data + priv->serial_number_start_offset + SERIAL_PART_OFFSET);
-	priv->firmware_version = get_unaligned_be16(data + priv->firmware_version_offset);
+	for (i = 0; i < ARRAY_SIZE(aqc_hwmon_types); i++) {
+		num_channels = aqc_num_channels(priv, aqc_hwmon_types[i]);
+		if (!num_channels)
+			continue;
 
-	/* Normal temperature sensor readings */
-	for (i = 0; i < priv->num_temp_sensors; i++) {
-		sensor_value = get_unaligned_be16(data +
-						  priv->temp_sensor_start_offset +
-						  i * AQC_SENSOR_SIZE);
-		if (sensor_value == AQC_SENSOR_NA)
-			priv->temp_input[i] = -ENODATA;
-		else
-			priv->temp_input[i] = sensor_value * 10;
-	}
+		/* Zero terminated */
+		config = devm_kcalloc(dev, num_channels + 1, sizeof(*config), GFP_KERNEL);
+		if (!config)
+			return ERR_PTR(-ENOMEM);
 
-	/* Virtual temperature sensor readings */
-	for (j = 0; j < priv->num_virtual_temp_sensors; j++) {
-		sensor_value = get_unaligned_be16(data +
-						  priv->virtual_temp_sensor_start_offset +
-						  j * AQC_SENSOR_SIZE);
-		if (sensor_value == AQC_SENSOR_NA)
-			priv->temp_input[i] = -ENODATA;
-		else
-			priv->temp_input[i] = sensor_value * 10;
-		i++;
+		for (channel = 0; channel < num_channels; channel++)
+			config[channel] = aqc_channel_config(priv, aqc_hwmon_types[i], channel);
+
+		channels[num_info].type = aqc_hwmon_types[i];
+		channels[num_info].config = config;
+		info[num_info] = &channels[num_info];
+		num_info++;
 	}
 
-	/* Fan speed and related readings */
-	for (i = 0; i < priv->num_fans; i++) {
-		priv->speed_input[i] =
-		    get_unaligned_be16(data + priv->fan_sensor_offsets[i] +
-				       priv->fan_structure->speed);
-		priv->power_input[i] =
-		    get_unaligned_be16(data + priv->fan_sensor_offsets[i] +
-				       priv->fan_structure->power) * 10000;
-		priv->voltage_input[i] =
-		    get_unaligned_be16(data + priv->fan_sensor_offsets[i] +
-				       priv->fan_structure->voltage) * 10;
-		priv->current_input[i] =
-		    get_unaligned_be16(data + priv->fan_sensor_offsets[i] +
-				       priv->fan_structure->curr);
+	chip_info->ops = &aqc_hwmon_ops;
+	chip_info->info = info;
+
+	return chip_info;
+}
+
+/* Parses the sensor values of a report, as described by the device's sensor descriptors */
+static void aqc_parse_sensors(struct aqc_data *priv, const u8 *data)
+{
+	const struct aqc_sensor_desc *desc;
+	const u8 *src;
+	s32 *dest;
+	u16 value;
+	int i, j;
+
+	for (i = 0; i < priv->info->num_sensor_descs; i++) {
+		desc = &priv->info->sensor_descs[i];
+		src = data + desc->offset;
+		dest = priv->sensors[desc->type] + desc->index;
+
+		for (j = 0; j < desc->count; j++, src += desc->stride) {
+			value = get_unaligned_be16(src);
+
+			if ((desc->flags & AQC_DESC_NA) && value == AQC_SENSOR_NA)
+				dest[j] = -ENODATA;
+			else if (desc->flags & AQC_DESC_SIGNED)
+				dest[j] = (s16)value * desc->scale;
+			else
+				dest[j] = value * desc->scale;
+		}
 	}
+}
 
-	/* Flow sensor readings */
-	for (j = 0; j < priv->num_flow_sensors; j++) {
-		priv->speed_input[i] = get_unaligned_be16(data + priv->flow_sensors_start_offset +
-							  j * AQC_SENSOR_SIZE);
-		i++;
+static int aqc_raw_event(struct hid_device *hdev, struct hid_report *report, u8 *data, int size)
+{
+	struct aqc_data *priv = hid_get_drvdata(hdev);
+	u64 start = ktime_get_ns();
+	unsigned long flags;
+
+	priv->stats.reports[report->id & 0xff]++;
+	if (report->id != STATUS_REPORT_ID) {
+		priv->stats.reports_ignored++;
+		return 0;
 	}
 
-	if (priv->power_cycle_count_offset != 0)
-		priv->power_cycles = get_unaligned_be32(data + priv->power_cycle_count_offset);
+	aqc_raw_push(priv, report->id, data, size);
+
+	write_seqlock_irqsave(&priv->sensor_lock, flags);
+
+	/* Info provided with every report */
+	priv->serial_number[0] = get_unaligned_be16(data + priv->info->serial_number_start_offset);
+	priv->serial_number[1] =
+	    get_unaligned_be16(data + priv->info->serial_number_start_offset + SERIAL_PART_OFFSET);
+	priv->firmware_version = get_unaligned_be16(data + priv->info->firmware_version_offset);
+
+	aqc_parse_sensors(priv, data);
+
+	if (priv->info->power_cycle_count_offset != 0)
+		priv->power_cycles =
+		    get_unaligned_be32(data + priv->info->power_cycle_count_offset);
 
 	/* Special-case sensor readings */
-	switch (priv->kind) {
+	switch (priv->info->kind) {
 	case aquaero:
 		/* Read hardware version (for v5: 5600, for v6: 6000) */
 		priv->aquaero_hw_version = get_unaligned_be16(data + AQUAERO_HARDWARE_VERSION);
@@ -2637,107 +4650,36 @@ static int aqc_raw_event(struct hid_device *hdev, struct hid_report *report, u8
 			break;
 		}
 
-		priv->current_uptime = get_unaligned_be32(data + AQUAERO_CURRENT_UPTIME_OFFSET);
-		priv->total_uptime = get_unaligned_be32(data + AQUAERO_TOTAL_UPTIME_OFFSET);
-
-		/* Read Aquabus flow sensors */
-		for (j = 0; j < priv->num_aquabus_flow_sensors; j++) {
-			sensor_value = get_unaligned_be16(data +
-							  priv->aquabus_flow_sensors_start_offset +
-							  j * AQC_SENSOR_SIZE);
-
-			if (sensor_value == AQC_SENSOR_NA)
-				priv->speed_input[i] = -ENODATA;
-			else
-				priv->speed_input[i] = sensor_value;
-			i++;
-		}
-
-		/* Read calculated virtual temp sensors */
-		i = priv->num_temp_sensors + priv->num_virtual_temp_sensors;
-		for (j = 0; j < priv->num_calc_virt_temp_sensors; j++) {
-			sensor_value = get_unaligned_be16(data +
-							  priv->calc_virt_temp_sensor_start_offset
-							  + j * AQC_SENSOR_SIZE);
-			if (sensor_value == AQC_SENSOR_NA)
-				priv->temp_input[i] = -ENODATA;
-			else
-				priv->temp_input[i] = sensor_value * 10;
-			i++;
-		}
-
-		/* Read Aquabus temp sensors */
-		for (j = 0; j < priv->num_aquabus_temp_sensors; j++) {
-			sensor_value = get_unaligned_be16(data +
-							  priv->aquabus_temp_sensor_start_offset
-							  + j * AQC_SENSOR_SIZE);
-			if (sensor_value == AQC_SENSOR_NA)
-				priv->temp_input[i] = -ENODATA;
-			else
-				priv->temp_input[i] = sensor_value * 10;
-			i++;
-		}
-
-		if (!completion_done(&priv->aquaero_sensor_report_received))
-			complete_all(&priv->aquaero_sensor_report_received);
-		break;
-	case aquastreamult:
-		priv->speed_input[1] = get_unaligned_be16(data + AQUASTREAMULT_PUMP_OFFSET);
-		priv->speed_input[2] = get_unaligned_be16(data + AQUASTREAMULT_PRESSURE_OFFSET);
-		priv->speed_input[3] = get_unaligned_be16(data + AQUASTREAMULT_FLOW_SENSOR_OFFSET);
-
-		priv->power_input[1] = get_unaligned_be16(data + AQUASTREAMULT_PUMP_POWER) * 10000;
-
-		priv->voltage_input[1] = get_unaligned_be16(data + AQUASTREAMULT_PUMP_VOLTAGE) * 10;
-
-		priv->current_input[1] = get_unaligned_be16(data + AQUASTREAMULT_PUMP_CURRENT);
-		break;
-	case d5next:
-		priv->voltage_input[2] = get_unaligned_be16(data + D5NEXT_5V_VOLTAGE) * 10;
-		priv->voltage_input[3] = get_unaligned_be16(data + D5NEXT_12V_VOLTAGE) * 10;
+		priv->current_uptime = get_unaligned_be32(data + AQUAERO_CURRENT_UPTIME_OFFSET);
+		priv->total_uptime = get_unaligned_be32(data + AQUAERO_TOTAL_UPTIME_OFFSET);
 		break;
 	case highflownext:
 		/* If external temp sensor is not connected, its power reading is also N/A */
-		if (priv->temp_input[1] == -ENODATA)
-			priv->power_input[0] = -ENODATA;
-		else
-			priv->power_input[0] =
-			    get_unaligned_be16(data + HIGHFLOWNEXT_POWER) * 1000000;
-
-		priv->voltage_input[0] = get_unaligned_be16(data + HIGHFLOWNEXT_5V_VOLTAGE) * 10;
-		priv->voltage_input[1] =
-		    get_unaligned_be16(data + HIGHFLOWNEXT_5V_VOLTAGE_USB) * 10;
-
-		priv->speed_input[1] = get_unaligned_be16(data + HIGHFLOWNEXT_WATER_QUALITY);
-		priv->speed_input[2] = get_unaligned_be16(data + HIGHFLOWNEXT_CONDUCTIVITY);
-		break;
-	case leakshield:
-		priv->speed_input[0] =
-		    ((s16)get_unaligned_be16(data + LEAKSHIELD_PRESSURE_ADJUSTED)) * 100;
-		priv->speed_input_min[0] = get_unaligned_be16(data + LEAKSHIELD_PRESSURE_MIN) * 100;
-		priv->speed_input_target[0] =
-		    get_unaligned_be16(data + LEAKSHIELD_PRESSURE_TARGET) * 100;
-		priv->speed_input_max[0] = get_unaligned_be16(data + LEAKSHIELD_PRESSURE_MAX) * 100;
-
-		priv->speed_input[1] = get_unaligned_be16(data + LEAKSHIELD_PUMP_RPM_IN);
-		if (priv->speed_input[1] == AQC_SENSOR_NA)
-			priv->speed_input[1] = -ENODATA;
-
-		priv->speed_input[2] = get_unaligned_be16(data + LEAKSHIELD_FLOW_IN);
-		if (priv->speed_input[2] == AQC_SENSOR_NA)
-			priv->speed_input[2] = -ENODATA;
-
-		priv->speed_input[3] = get_unaligned_be16(data + LEAKSHIELD_RESERVOIR_VOLUME);
-		priv->speed_input[4] = get_unaligned_be16(data + LEAKSHIELD_RESERVOIR_FILLED);
-
-		/* Second temp sensor is not positioned after the first one, read it here */
-		priv->temp_input[1] = get_unaligned_be16(data + LEAKSHIELD_TEMPERATURE_2) * 10;
+		if (priv->sensors[AQC_TEMP][1] == -ENODATA)
+			priv->sensors[AQC_POWER][0] = -ENODATA;
 		break;
 	default:
 		break;
 	}
 
 	priv->updated = jiffies;
+	priv->report_time = ktime_get_ns();
+	priv->report_seq++;
+	aqc_update_sensors_page(priv);
+
+	write_sequnlock_irqrestore(&priv->sensor_lock, flags);
+
+	aqc_notify_report(priv);
+	aqc_genl_notify(priv, GFP_ATOMIC);
+	aqc_iio_push(priv);
+	trace_aqc_sensor_report(priv->hdev, priv->info->name, priv->serial_number,
+				priv->report_seq, priv->info->num_values, priv->sensors[0],
+				priv->num_sensor_values);
+
+	if (priv->info->kind == aquaero && !completion_done(&priv->aquaero_sensor_report_received))
+		complete_all(&priv->aquaero_sensor_report_received);
+
+	aqc_hist_add(&priv->stats.raw_event, ktime_get_ns() - start);
 
 	return 0;
 }
@@ -2816,45 +4758,375 @@ static int total_uptime_show(struct seq_file *seqf, void *unused)
 }
 DEFINE_SHOW_ATTRIBUTE(total_uptime);
 
+/*
+ * Reads whole struct aqc_raw_record entries, as many as fit into the buffer. The file
+ * position is the count of reports already read, so reports that were overwritten
+ * before being read can be noticed by a gap in seq
+ */
+static bool aqc_raw_available(struct aqc_data *priv, unsigned long pos)
+{
+	unsigned long flags;
+	bool ret;
+
+	spin_lock_irqsave(&priv->raw_lock, flags);
+	ret = priv->raw_head != pos || priv->raw_closed;
+	spin_unlock_irqrestore(&priv->raw_lock, flags);
+
+	return ret;
+}
+
+static ssize_t raw_reports_read(struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+	struct aqc_data *priv = file->private_data;
+	struct aqc_raw_record *rec;
+	unsigned long pos = *ppos;
+	size_t copied = 0;
+	int ret = 0;
+
+	if (count < sizeof(*rec))
+		return -EINVAL;
+
+	if (!(file->f_flags & O_NONBLOCK)) {
+		ret = wait_event_interruptible(priv->raw_wait, aqc_raw_available(priv, pos));
+		if (ret < 0)
+			return ret;
+	}
+
+	rec = kmalloc(sizeof(*rec), GFP_KERNEL);
+	if (!rec)
+		return -ENOMEM;
+
+	while (count - copied >= sizeof(*rec)) {
+		spin_lock_irq(&priv->raw_lock);
+		if (pos == priv->raw_head) {
+			spin_unlock_irq(&priv->raw_lock);
+			break;
+		}
+
+		/* Skip to the oldest report still in history */
+		if (priv->raw_head - pos > priv->raw_depth)
+			pos = priv->raw_head - priv->raw_depth;
+
+		memcpy(rec, &priv->raw_ring[pos % priv->raw_depth], sizeof(*rec));
+		spin_unlock_irq(&priv->raw_lock);
+
+		if (copy_to_user(buf + copied, rec, sizeof(*rec))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		copied += sizeof(*rec);
+		pos++;
+	}
+
+	kfree(rec);
+
+	if (copied == 0) {
+		if (ret < 0)
+			return ret;
+		/* Nothing new, or the device is going away */
+		return priv->raw_closed ? 0 : -EAGAIN;
+	}
+
+	*ppos = pos;
+	return copied;
+}
+
+static __poll_t raw_reports_poll(struct file *file, poll_table *wait)
+{
+	struct aqc_data *priv = file->private_data;
+
+	poll_wait(file, &priv->raw_wait, wait);
+
+	return aqc_raw_available(priv, file->f_pos) ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+static const struct file_operations raw_reports_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = raw_reports_read,
+	.poll = raw_reports_poll,
+	.llseek = noop_llseek,
+};
+
+static const char * const aqc_sensor_names[AQC_SENSOR_TYPES] = {
+	[AQC_TEMP] = "temp",
+	[AQC_SPEED] = "fan",
+	[AQC_SPEED_MIN] = "fan_min",
+	[AQC_SPEED_TARGET] = "fan_target",
+	[AQC_SPEED_MAX] = "fan_max",
+	[AQC_POWER] = "power",
+	[AQC_VOLTAGE] = "in",
+	[AQC_CURRENT] = "curr",
+};
+
+/* Prints the sensor values of the last report of a device on one line */
+static int aqc_sensors_show_device(struct seq_file *seqf, struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	u32 serial_number[2];
+	unsigned long report_seq;
+	int i, j, num_values = 0;
+	unsigned int seq;
+	u64 report_time;
+	s32 *values;
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++)
+		num_values += info->num_values[i];
+
+	values = kmalloc_array(num_values, sizeof(*values), GFP_KERNEL);
+	if (!values)
+		return -ENOMEM;
+
+	/* The values of all types are allocated in one piece, starting at sensors[0] */
+	do {
+		seq = read_seqbegin(&priv->sensor_lock);
+		serial_number[0] = priv->serial_number[0];
+		serial_number[1] = priv->serial_number[1];
+		report_seq = priv->report_seq;
+		report_time = priv->report_time;
+		memcpy(values, priv->sensors[0], num_values * sizeof(*values));
+	} while (read_seqretry(&priv->sensor_lock, seq));
+
+	seq_printf(seqf, "%s %05u-%05u seq=%lu timestamp=%llu", info->name, serial_number[0],
+		   serial_number[1], report_seq, report_time);
+
+	num_values = 0;
+	for (i = 0; i < AQC_SENSOR_TYPES; i++) {
+		if (!info->num_values[i])
+			continue;
+
+		seq_printf(seqf, " %s=", aqc_sensor_names[i]);
+		for (j = 0; j < info->num_values[i]; j++)
+			seq_printf(seqf, j ? ",%d" : "%d", values[num_values++]);
+	}
+	seq_putc(seqf, '\n');
+
+	kfree(values);
+	return 0;
+}
+
+static int aqc_sensors_show(struct seq_file *seqf, void *unused)
+{
+	struct aqc_data *priv;
+	int ret = 0;
+
+	mutex_lock(&aqc_devices_lock);
+	list_for_each_entry(priv, &aqc_devices, node) {
+		ret = aqc_sensors_show_device(seqf, priv);
+		if (ret < 0)
+			break;
+	}
+	mutex_unlock(&aqc_devices_lock);
+
+	return ret;
+}
+DEFINE_SHOW_ATTRIBUTE(aqc_sensors);
+
+static struct dentry *aqc_debugfs_sensors;
+
+static void aqc_debugfs_register(void)
+{
+	aqc_debugfs_sensors = debugfs_create_file("aquacomputer_sensors", 0444, NULL, NULL,
+						  &aqc_sensors_fops);
+}
+
+static void aqc_debugfs_unregister(void)
+{
+	debugfs_remove(aqc_debugfs_sensors);
+}
+
+static void aqc_hist_show(struct seq_file *seqf, const char *name, const struct aqc_hist *hist)
+{
+	int i;
+
+	seq_printf(seqf, "%s: count=%llu total_ns=%llu max_ns=%llu\n", name, hist->count,
+		   hist->total_ns, hist->max_ns);
+	for (i = 0; i < AQC_HIST_BUCKETS; i++)
+		if (hist->buckets[i])
+			seq_printf(seqf, "  [2^%d ns]: %u\n", i, hist->buckets[i]);
+}
+
+static int stats_show(struct seq_file *seqf, void *unused)
+{
+	struct aqc_data *priv = seqf->private;
+	struct aqc_stats *stats = &priv->stats;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(stats->reports); i++)
+		if (stats->reports[i])
+			seq_printf(seqf, "reports[0x%02x]: %u\n", i, stats->reports[i]);
+	seq_printf(seqf, "reports_ignored: %u\n", stats->reports_ignored);
+	aqc_hist_show(seqf, "raw_event", &stats->raw_event);
+
+	if (priv->info->status_report_id != 0) {
+		aqc_hist_show(seqf, "legacy_poll", &stats->legacy_poll);
+		seq_printf(seqf, "legacy_poll_errors: %u\n", stats->legacy_poll_errors);
+	}
+
+	aqc_hist_show(seqf, "ctrl_get", &stats->ctrl_get);
+	aqc_hist_show(seqf, "ctrl_set", &stats->ctrl_set);
+	aqc_hist_show(seqf, "ctrl_secondary", &stats->ctrl_secondary);
+	seq_printf(seqf, "ctrl_delays: %u\n", stats->ctrl_delays);
+	seq_printf(seqf, "ctrl_delay_ns: %llu\n", stats->ctrl_delay_ns);
+	seq_printf(seqf, "ctrl_elided: %u\n", stats->ctrl_elided);
+	seq_printf(seqf, "ctrl_stale: %u\n", stats->ctrl_stale);
+	seq_printf(seqf, "ctrl_backoffs: %u\n", stats->ctrl_backoffs);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+/* Maps the page with the last sensor values read-only, for reading them without syscalls */
+static int sensors_page_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct aqc_data *priv = file->private_data;
+	int ret;
+
+	if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	/* The file isn't proxied by debugfs, so guard against the device going away */
+	ret = debugfs_file_get(file->f_path.dentry);
+	if (ret)
+		return ret;
+
+#if KERNEL_VERSION(6, 3, 0) <= LINUX_VERSION_CODE
+	vm_flags_mod(vma, VM_DONTEXPAND | VM_DONTDUMP, VM_MAYWRITE);
+#else
+	vma->vm_flags = (vma->vm_flags | VM_DONTEXPAND | VM_DONTDUMP) & ~VM_MAYWRITE;
+#endif
+
+	/* The mapping holds a reference to the page, so it outlives the device */
+	ret = vm_insert_page(vma, vma->vm_start, virt_to_page(priv->sensors_page));
+
+	debugfs_file_put(file->f_path.dentry);
+	return ret;
+}
+
+static const struct file_operations sensors_page_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.mmap = sensors_page_mmap,
+	.llseek = noop_llseek,
+};
+
 static void aqc_debugfs_init(struct aqc_data *priv)
 {
 	char name[64];
 
-	scnprintf(name, sizeof(name), "%s_%s-%s", "aquacomputer", priv->name,
+	scnprintf(name, sizeof(name), "%s_%s-%s", "aquacomputer", priv->info->name,
 		  dev_name(&priv->hdev->dev));
 
 	priv->debugfs = debugfs_create_dir(name, NULL);
 
-	if (priv->serial_number_start_offset != 0)
+	if (priv->info->serial_number_start_offset != 0)
 		debugfs_create_file("serial_number", 0444, priv->debugfs, priv,
 				    &serial_number_fops);
-	if (priv->firmware_version_offset != 0)
+	if (priv->info->firmware_version_offset != 0)
 		debugfs_create_file("firmware_version", 0444, priv->debugfs, priv,
 				    &firmware_version_fops);
-	if (priv->power_cycle_count_offset != 0)
+	if (priv->info->power_cycle_count_offset != 0)
 		debugfs_create_file("power_cycles", 0444, priv->debugfs, priv, &power_cycles_fops);
 
-	if (priv->kind == aquaero) {
+	if (priv->info->kind == aquaero) {
 		debugfs_create_file("hw_version", 0444, priv->debugfs, priv, &hw_version_fops);
 		debugfs_create_file("current_uptime", 0444, priv->debugfs, priv,
 				    &current_uptime_fops);
 		debugfs_create_file("total_uptime", 0444, priv->debugfs, priv, &total_uptime_fops);
 	}
+
+	if (priv->raw_ring)
+		debugfs_create_file("raw_reports", 0400, priv->debugfs, priv, &raw_reports_fops);
+	if (priv->sensors_page)
+		debugfs_create_file_unsafe("sensors_page", 0444, priv->debugfs, priv,
+					   &sensors_page_fops);
+	debugfs_create_file("stats", 0444, priv->debugfs, priv, &stats_fops);
 }
 
 #else
 
+static void aqc_debugfs_register(void)
+{
+}
+
+static void aqc_debugfs_unregister(void)
+{
+}
+
 static void aqc_debugfs_init(struct aqc_data *priv)
 {
 }
 
 #endif
 
+/* Allocates storage for the sensor values of the device, in one piece */
+static int aqc_alloc_sensors(struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	const struct aqc_sensor_desc *desc;
+	int i, total = 0;
+	s32 *values;
+
+	/* Sensor reports are parsed in interrupt context, so check the descriptors once here */
+	for (i = 0; i < info->num_sensor_descs; i++) {
+		desc = &info->sensor_descs[i];
+		if (desc->index + desc->count > info->num_values[desc->type]) {
+			hid_err(priv->hdev, "sensor descriptor %d out of range\n", i);
+			return -EINVAL;
+		}
+	}
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++)
+		total += info->num_values[i];
+
+	values = devm_kcalloc(&priv->hdev->dev, total, sizeof(*values), GFP_KERNEL);
+	if (!values)
+		return -ENOMEM;
+
+	priv->num_sensor_values = total;
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++) {
+		priv->sensors[i] = values;
+		values += info->num_values[i];
+	}
+
+	return 0;
+}
+
+/* Allocates the page that the sensor values are mapped from, with the record header set up */
+static int aqc_alloc_sensors_page(struct aqc_data *priv)
+{
+	const struct aqc_device_info *info = priv->info;
+	struct aqc_sensors_page *page;
+	int i, num_values = 0;
+
+	for (i = 0; i < AQC_SENSOR_TYPES; i++)
+		num_values += info->num_values[i];
+
+	if (struct_size(page, record.values, num_values) > PAGE_SIZE)
+		return -EINVAL;
+
+	page = (struct aqc_sensors_page *)get_zeroed_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	page->record.version = AQC_SENSORS_VERSION;
+	page->record.size = struct_size(&page->record, values, num_values);
+	memcpy(page->record.num_values, info->num_values, sizeof(info->num_values));
+	priv->sensors_page = page;
+
+	return 0;
+}
+
 static int aqc_probe(struct hid_device *hdev, const struct hid_device_id *id)
 {
+	const struct hwmon_chip_info *chip_info;
 	struct aqc_data *priv;
 	struct attribute_group *group;
-	int ret, groups;
+	int ret, groups = 0;
 
 	priv = devm_kzalloc(&hdev->dev, sizeof(*priv), GFP_KERNEL);
 	if (!priv)
@@ -2863,7 +5135,8 @@ static int aqc_probe(struct hid_device *hdev, const struct hid_device_id *id)
 	priv->hdev = hdev;
 	hid_set_drvdata(hdev, priv);
 
-	priv->updated = jiffies - STATUS_UPDATE_INTERVAL;
+	/* Readings are stale until the first report, whatever the update interval */
+	priv->updated = jiffies - 2 * msecs_to_jiffies(UPDATE_INTERVAL_MAX);
 
 	ret = hid_parse(hdev);
 	if (ret)
@@ -2895,173 +5168,26 @@ static int aqc_probe(struct hid_device *hdev, const struct hid_device_id *id)
 			goto fail_and_close;
 		}
 
-		priv->kind = aquaero;
-
-		priv->num_fans = AQUAERO_NUM_FANS;
-		priv->fan_sensor_offsets = aquaero_sensor_fan_offsets;
-		priv->fan_ctrl_offsets = aquaero_ctrl_fan_offsets;
-
-		priv->num_temp_sensors = AQUAERO_NUM_SENSORS;
-		priv->temp_sensor_start_offset = AQUAERO_SENSOR_START;
-		priv->num_virtual_temp_sensors = AQUAERO_NUM_VIRTUAL_SENSORS;
-		priv->virtual_temp_sensor_start_offset = AQUAERO_VIRTUAL_SENSOR_START;
-		priv->num_calc_virt_temp_sensors = AQUAERO_NUM_CALC_VIRTUAL_SENSORS;
-		priv->calc_virt_temp_sensor_start_offset = AQUAERO_CALC_VIRTUAL_SENSOR_START;
-		priv->num_aquabus_temp_sensors = AQUAERO_NUM_AQUABUS_SENSORS;
-		priv->aquabus_temp_sensor_start_offset = AQUAERO_AQUABUS_SENSOR_START;
-		priv->num_flow_sensors = AQUAERO_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = AQUAERO_FLOW_SENSORS_START;
-		priv->num_aquabus_flow_sensors = AQUAERO_NUM_AQUABUS_FLOW_SENSORS;
-		priv->aquabus_flow_sensors_start_offset = AQUAERO_AQUABUS_FLOW_SENSORS_START;
-
-		priv->buffer_size = AQUAERO_CTRL_REPORT_SIZE;
-		priv->temp_ctrl_offset = AQUAERO_TEMP_CTRL_OFFSET;
-		priv->ctrl_report_delay = CTRL_REPORT_DELAY;
-
-		priv->temp_label = label_temp_sensors;
-		priv->virtual_temp_label = label_virtual_temp_sensors;
-		priv->calc_virtual_temp_label = label_aquaero_calc_temp_sensors;
-		priv->aquabus_temp_label = label_aquaero_aquabus_temp_sensors;
-		priv->speed_label = label_aquaero_speeds;
-		priv->power_label = label_fan_power;
-		priv->voltage_label = label_fan_voltage;
-		priv->current_label = label_fan_current;
+		priv->info = &aquaero_info;
+		init_completion(&priv->aquaero_sensor_report_received);
 		break;
 	case USB_PRODUCT_ID_D5NEXT:
-		priv->kind = d5next;
-
-		priv->num_fans = D5NEXT_NUM_FANS;
-		priv->fan_sensor_offsets = d5next_sensor_fan_offsets;
-		priv->fan_ctrl_offsets = d5next_ctrl_fan_offsets;
-		priv->fan_curve_min_power_offsets = d5next_ctrl_fan_curve_min_power_offsets;
-		priv->fan_curve_max_power_offsets = d5next_ctrl_fan_curve_max_power_offsets;
-		priv->fan_curve_hold_start_offsets = d5next_ctrl_fan_curve_hold_start_offsets;
-		priv->fan_curve_fallback_power_offsets =
-		    d5next_ctrl_fan_curve_fallback_power_offsets;
-
-		priv->num_temp_sensors = D5NEXT_NUM_SENSORS;
-		priv->temp_sensor_start_offset = D5NEXT_COOLANT_TEMP;
-		priv->num_virtual_temp_sensors = D5NEXT_NUM_VIRTUAL_SENSORS;
-		priv->virtual_temp_sensor_start_offset = D5NEXT_VIRTUAL_SENSORS_START;
-
-		priv->power_cycle_count_offset = AQC_POWER_CYCLES;
-		priv->buffer_size = D5NEXT_CTRL_REPORT_SIZE;
-		priv->temp_ctrl_offset = D5NEXT_TEMP_CTRL_OFFSET;
-		priv->ctrl_report_delay = CTRL_REPORT_DELAY;
-
-		priv->temp_label = label_d5next_temp;
-		priv->virtual_temp_label = label_virtual_temp_sensors;
-		priv->speed_label = label_d5next_speeds;
-		priv->power_label = label_d5next_power;
-		priv->voltage_label = label_d5next_voltages;
-		priv->current_label = label_d5next_current;
+		priv->info = &d5next_info;
 		break;
 	case USB_PRODUCT_ID_FARBWERK:
-		priv->kind = farbwerk;
-
-		priv->num_fans = 0;
-
-		priv->num_temp_sensors = FARBWERK_NUM_SENSORS;
-		priv->temp_sensor_start_offset = FARBWERK_SENSOR_START;
-
-		priv->temp_ctrl_offset = 0;
-
-		priv->temp_label = label_temp_sensors;
+		priv->info = &farbwerk_info;
 		break;
 	case USB_PRODUCT_ID_FARBWERK360:
-		priv->kind = farbwerk360;
-
-		priv->num_fans = 0;
-
-		priv->num_temp_sensors = FARBWERK360_NUM_SENSORS;
-		priv->temp_sensor_start_offset = FARBWERK360_SENSOR_START;
-		priv->num_virtual_temp_sensors = FARBWERK360_NUM_VIRTUAL_SENSORS;
-		priv->virtual_temp_sensor_start_offset = FARBWERK360_VIRTUAL_SENSORS_START;
-
-		priv->buffer_size = FARBWERK360_CTRL_REPORT_SIZE;
-		priv->temp_ctrl_offset = FARBWERK360_TEMP_CTRL_OFFSET;
-
-		priv->temp_label = label_temp_sensors;
-		priv->virtual_temp_label = label_virtual_temp_sensors;
+		priv->info = &farbwerk360_info;
 		break;
 	case USB_PRODUCT_ID_OCTO:
-		priv->kind = octo;
-
-		priv->num_fans = OCTO_NUM_FANS;
-		priv->fan_sensor_offsets = octo_sensor_fan_offsets;
-		priv->fan_ctrl_offsets = octo_ctrl_fan_offsets;
-		priv->fan_curve_min_power_offsets = octo_ctrl_fan_curve_min_power_offsets;
-		priv->fan_curve_max_power_offsets = octo_ctrl_fan_curve_max_power_offsets;
-		priv->fan_curve_hold_start_offsets = octo_ctrl_fan_curve_hold_start_offsets;
-		priv->fan_curve_fallback_power_offsets = octo_ctrl_fan_curve_fallback_power_offsets;
-
-		priv->num_temp_sensors = OCTO_NUM_SENSORS;
-		priv->temp_sensor_start_offset = OCTO_SENSOR_START;
-		priv->num_virtual_temp_sensors = OCTO_NUM_VIRTUAL_SENSORS;
-		priv->virtual_temp_sensor_start_offset = OCTO_VIRTUAL_SENSORS_START;
-		priv->num_flow_sensors = OCTO_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = OCTO_FLOW_SENSOR_OFFSET;
-
-		priv->power_cycle_count_offset = AQC_POWER_CYCLES;
-		priv->buffer_size = OCTO_CTRL_REPORT_SIZE;
-		priv->ctrl_report_delay = CTRL_REPORT_DELAY;
-		priv->temp_ctrl_offset = OCTO_TEMP_CTRL_OFFSET;
-		priv->flow_pulses_ctrl_offset = OCTO_FLOW_PULSES_CTRL_OFFSET;
-
-		priv->temp_label = label_temp_sensors;
-		priv->virtual_temp_label = label_virtual_temp_sensors;
-		priv->speed_label = label_octo_speeds;
-		priv->power_label = label_fan_power;
-		priv->voltage_label = label_fan_voltage;
-		priv->current_label = label_fan_current;
+		priv->info = &octo_info;
 		break;
 	case USB_PRODUCT_ID_QUADRO:
-		priv->kind = quadro;
-
-		priv->num_fans = QUADRO_NUM_FANS;
-		priv->fan_sensor_offsets = quadro_sensor_fan_offsets;
-		priv->fan_ctrl_offsets = quadro_ctrl_fan_offsets;
-		priv->fan_curve_min_power_offsets = quadro_ctrl_fan_curve_min_power_offsets;
-		priv->fan_curve_max_power_offsets = quadro_ctrl_fan_curve_max_power_offsets;
-		priv->fan_curve_hold_start_offsets = quadro_ctrl_fan_curve_hold_start_offsets;
-		priv->fan_curve_fallback_power_offsets =
-		    quadro_ctrl_fan_curve_fallback_power_offsets;
-
-		priv->num_temp_sensors = QUADRO_NUM_SENSORS;
-		priv->temp_sensor_start_offset = QUADRO_SENSOR_START;
-		priv->num_virtual_temp_sensors = QUADRO_NUM_VIRTUAL_SENSORS;
-		priv->virtual_temp_sensor_start_offset = QUADRO_VIRTUAL_SENSORS_START;
-		priv->num_flow_sensors = QUADRO_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = QUADRO_FLOW_SENSOR_OFFSET;
-
-		priv->power_cycle_count_offset = AQC_POWER_CYCLES;
-		priv->buffer_size = QUADRO_CTRL_REPORT_SIZE;
-		priv->ctrl_report_delay = CTRL_REPORT_DELAY;
-		priv->temp_ctrl_offset = QUADRO_TEMP_CTRL_OFFSET;
-		priv->flow_pulses_ctrl_offset = QUADRO_FLOW_PULSES_CTRL_OFFSET;
-
-		priv->temp_label = label_temp_sensors;
-		priv->virtual_temp_label = label_virtual_temp_sensors;
-		priv->speed_label = label_quadro_speeds;
-		priv->power_label = label_fan_power;
-		priv->voltage_label = label_fan_voltage;
-		priv->current_label = label_fan_current;
+		priv->info = &quadro_info;
 		break;
 	case USB_PRODUCT_ID_HIGHFLOWNEXT:
-		priv->kind = highflownext;
-
-		priv->num_fans = 0;
-		priv->num_temp_sensors = HIGHFLOWNEXT_NUM_SENSORS;
-		priv->temp_sensor_start_offset = HIGHFLOWNEXT_SENSOR_START;
-		priv->num_flow_sensors = HIGHFLOWNEXT_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = HIGHFLOWNEXT_FLOW;
-
-		priv->power_cycle_count_offset = AQC_POWER_CYCLES;
-
-		priv->temp_label = label_highflownext_temp_sensors;
-		priv->speed_label = label_highflownext_fan_speed;
-		priv->power_label = label_highflownext_power;
-		priv->voltage_label = label_highflownext_voltage;
+		priv->info = &highflownext_info;
 		break;
 	case USB_PRODUCT_ID_LEAKSHIELD:
 		/*
@@ -3073,195 +5199,161 @@ static int aqc_probe(struct hid_device *hdev, const struct hid_device_id *id)
 			goto fail_and_close;
 		}
 
-		priv->kind = leakshield;
-
-		priv->num_fans = 0;
-		priv->num_temp_sensors = LEAKSHIELD_NUM_SENSORS;
-		priv->temp_sensor_start_offset = LEAKSHIELD_TEMPERATURE_1;
-
-		/* Plus two bytes for checksum */
-		priv->buffer_size = LEAKSHIELD_USB_REPORT_LENGTH + 2;
-
-		priv->temp_label = label_leakshield_temp_sensors;
-		priv->speed_label = label_leakshield_fan_speed;
+		priv->info = &leakshield_info;
 		break;
 	case USB_PRODUCT_ID_AQUASTREAMXT:
-		priv->kind = aquastreamxt;
-
-		priv->num_fans = AQUASTREAMXT_NUM_FANS;
-		priv->fan_sensor_offsets = aquastreamxt_sensor_fan_offsets;
-		priv->fan_ctrl_offsets = aquastreamxt_ctrl_fan_offsets;
-
-		priv->num_temp_sensors = AQUASTREAMXT_NUM_SENSORS;
-		priv->temp_sensor_start_offset = AQUASTREAMXT_SENSOR_START;
-
-		/*
-		 * Since we use the same buffer for both sensor and control
-		 * report storage on legacy devices, reserve enough space
-		 */
-		priv->buffer_size = max(AQUASTREAMXT_SENSOR_REPORT_SIZE,
-					AQUASTREAMXT_CTRL_REPORT_SIZE);
-
-		priv->temp_label = label_aquastreamxt_temp_sensors;
-		priv->speed_label = label_d5next_speeds;
-		priv->voltage_label = label_d5next_voltages;
-		priv->current_label = label_d5next_current;
+		priv->info = &aquastreamxt_info;
 		break;
 	case USB_PRODUCT_ID_AQUASTREAMULT:
-		priv->kind = aquastreamult;
-
-		priv->num_fans = AQUASTREAMULT_NUM_FANS;
-		priv->fan_sensor_offsets = aquastreamult_sensor_fan_offsets;
-
-		priv->num_temp_sensors = AQUASTREAMULT_NUM_SENSORS;
-		priv->temp_sensor_start_offset = AQUASTREAMULT_SENSOR_START;
-
-		priv->temp_label = label_aquastreamult_temp;
-		priv->speed_label = label_aquastreamult_speeds;
-		priv->power_label = label_aquastreamult_power;
-		priv->voltage_label = label_aquastreamult_voltages;
-		priv->current_label = label_aquastreamult_current;
+		priv->info = &aquastreamult_info;
 		break;
 	case USB_PRODUCT_ID_POWERADJUST3:
-		priv->kind = poweradjust3;
-
-		priv->num_fans = POWERADJUST3_NUM_FANS;
-
-		priv->num_temp_sensors = POWERADJUST3_NUM_SENSORS;
-		priv->temp_sensor_start_offset = POWERADJUST3_SENSOR_START;
-		priv->num_flow_sensors = POWERADJUST3_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = POWERADJUST3_FLOW_SENSOR_OFFSET;
-		priv->buffer_size = POWERADJUST3_SENSOR_REPORT_SIZE;
-
-		priv->temp_label = label_poweradjust3_temp_sensors;
-		priv->speed_label = label_poweradjust3_speeds;
-		priv->voltage_label = label_poweradjust3_voltages;
-		priv->current_label = label_poweradjust3_current;
+		priv->info = &poweradjust3_info;
 		break;
 	case USB_PRODUCT_ID_HIGHFLOW:
-		priv->kind = highflow;
-
-		priv->num_fans = 0;
-
-		priv->num_temp_sensors = HIGHFLOW_NUM_SENSORS;
-		priv->temp_sensor_start_offset = HIGHFLOW_SENSOR_START;
-		priv->num_flow_sensors = HIGHFLOW_NUM_FLOW_SENSORS;
-		priv->flow_sensors_start_offset = HIGHFLOW_FLOW_SENSOR_OFFSET;
-		priv->buffer_size = HIGHFLOW_SENSOR_REPORT_SIZE;
-
-		priv->temp_label = label_highflow_temp;
-		priv->speed_label = label_highflow_speeds;
-		break;
-	default:
-		break;
-	}
-
-	switch (priv->kind) {
-	case aquaero:
-		init_completion(&priv->aquaero_sensor_report_received);
-
-		priv->serial_number_start_offset = AQUAERO_SERIAL_START;
-		priv->firmware_version_offset = AQUAERO_FIRMWARE_VERSION;
-
-		priv->fan_structure = &aqc_aquaero_fan_structure;
-
-		priv->ctrl_report_id = AQUAERO_CTRL_REPORT_ID;
-		priv->secondary_ctrl_report_id = AQUAERO_SECONDARY_CTRL_REPORT_ID;
-		priv->secondary_ctrl_report_size = AQUAERO_SECONDARY_CTRL_REPORT_SIZE;
-		priv->secondary_ctrl_report = aquaero_secondary_ctrl_report;
-		break;
-	case aquastreamxt:
-		priv->serial_number_start_offset = AQUASTREAMXT_SERIAL_START;
-		priv->firmware_version_offset = AQUASTREAMXT_FIRMWARE_VERSION;
-
-		priv->status_report_id = AQUASTREAMXT_STATUS_REPORT_ID;
-		priv->ctrl_report_id = AQUASTREAMXT_CTRL_REPORT_ID;
-		priv->secondary_ctrl_report_id = AQUASTREAMXT_SECONDARY_CTRL_REPORT_ID;
-		priv->secondary_ctrl_report_size = AQUASTREAMXT_SECONDARY_CTRL_REPORT_SIZE;
-		priv->secondary_ctrl_report = aquastreamxt_secondary_ctrl_report;
-		break;
-	case poweradjust3:
-		priv->serial_number_start_offset = POWERADJUST3_SERIAL_START;
-		priv->firmware_version_offset = POWERADJUST3_FIRMWARE_VERSION;
-
-		priv->status_report_id = POWERADJUST3_STATUS_REPORT_ID;
-		break;
-	case highflow:
-		priv->serial_number_start_offset = HIGHFLOW_SERIAL_START;
-		priv->firmware_version_offset = HIGHFLOW_FIRMWARE_VERSION;
-
-		priv->status_report_id = HIGHFLOW_STATUS_REPORT_ID;
+		priv->info = &highflow_info;
 		break;
 	default:
-		priv->serial_number_start_offset = AQC_SERIAL_START;
-		priv->firmware_version_offset = AQC_FIRMWARE_VERSION;
-
-		if (priv->kind == aquastreamult) {
-			priv->fan_structure = &aqc_aquastreamult_fan_structure;
-		} else {
-			priv->fan_structure = &aqc_general_fan_structure;
-
-			priv->ctrl_report_id = CTRL_REPORT_ID;
-			priv->secondary_ctrl_report_id = SECONDARY_CTRL_REPORT_ID;
-			priv->secondary_ctrl_report_size = SECONDARY_CTRL_REPORT_SIZE;
-			priv->secondary_ctrl_report = secondary_ctrl_report;
-		}
-		break;
+		ret = -ENODEV;
+		goto fail_and_close;
 	}
 
 	/* Set up temp-PWM curves and their parameters for devices that support them */
-	if (priv->fan_ctrl_offsets) {
-		switch (priv->kind) {
+	if (priv->info->fan_ctrl_offsets) {
+		switch (priv->info->kind) {
 		case d5next:
 		case octo:
 		case quadro:
 			/* Temp-PWM curve */
 			group =
 			    aqc_create_attr_group(&hdev->dev, &aqc_curve_template_group,
-						  priv->num_fans);
-			if (IS_ERR(group))
-				return PTR_ERR(group);
+						  priv->info->num_fans);
+			if (IS_ERR(group)) {
+				ret = PTR_ERR(group);
+				goto fail_and_close;
+			}
 			priv->groups[groups++] = group;
 
 			/* General curve parameters */
 			group =
 			    aqc_create_attr_group(&hdev->dev, &aqc_curve_params_template_group,
-						  priv->num_fans);
-			if (IS_ERR(group))
-				return PTR_ERR(group);
+						  priv->info->num_fans);
+			if (IS_ERR(group)) {
+				ret = PTR_ERR(group);
+				goto fail_and_close;
+			}
 			priv->groups[groups++] = group;
 			break;
 		default:
 			break;
 		}
-	}
 
-	if (priv->buffer_size != 0) {
-		priv->checksum_start = 0x01;
-		priv->checksum_length = priv->buffer_size - 3;
-		priv->checksum_offset = priv->buffer_size - 2;
+		/* PWM write deadband, for all devices with PWM control */
+		group = aqc_create_attr_group(&hdev->dev, &aqc_pwm_template_group,
+					      priv->info->num_fans);
+		if (IS_ERR(group)) {
+			ret = PTR_ERR(group);
+			goto fail_and_close;
+		}
+		priv->groups[groups++] = group;
 	}
 
-	priv->name = aqc_device_names[priv->kind];
+	priv->groups[groups++] = &aqc_ctrl_group;
+	priv->groups[groups++] = &aqc_status_group;
 
-	priv->buffer = devm_kzalloc(&hdev->dev, priv->buffer_size, GFP_KERNEL);
+	priv->buffer = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
 	if (!priv->buffer) {
 		ret = -ENOMEM;
 		goto fail_and_close;
 	}
 
-	if (priv->kind == leakshield)
+	if (priv->info->kind == leakshield)
 		memcpy(priv->buffer, leakshield_usb_report_template, LEAKSHIELD_USB_REPORT_LENGTH);
 
-	mutex_init(&priv->mutex);
+	priv->io_buffer = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	priv->ctrl_prev = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	priv->pending_buffer = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	priv->pending_mask = devm_bitmap_zalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	priv->inflight_buffer = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	priv->inflight_mask = devm_bitmap_zalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+	if (!priv->io_buffer || !priv->ctrl_prev || !priv->pending_buffer || !priv->pending_mask ||
+	    !priv->inflight_buffer || !priv->inflight_mask) {
+		ret = -ENOMEM;
+		goto fail_and_close;
+	}
+
+	if (priv->info->ctrl_report_delay) {
+		priv->ctrl_sent = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+		if (!priv->ctrl_sent) {
+			ret = -ENOMEM;
+			goto fail_and_close;
+		}
+
+		/* Start from the known safe delay and calibrate the floor from there */
+		priv->ctrl_delay_max = priv->info->ctrl_report_delay;
+		priv->ctrl_delay_min = min(CTRL_REPORT_DELAY_MIN, priv->ctrl_delay_max);
+		priv->ctrl_delay_floor = priv->ctrl_delay_min;
+		priv->ctrl_delay = priv->ctrl_delay_max;
+	}
+
+	if (priv->info->status_report_id != 0) {
+		priv->status_buffer = devm_kzalloc(&hdev->dev, priv->info->buffer_size, GFP_KERNEL);
+		if (!priv->status_buffer) {
+			ret = -ENOMEM;
+			goto fail_and_close;
+		}
+	}
+
+	ret = aqc_alloc_sensors(priv);
+	if (ret < 0)
+		goto fail_and_close;
+
+	/* Raw reports are only readable through debugfs */
+	if (IS_ENABLED(CONFIG_DEBUG_FS) && raw_history != 0) {
+		priv->raw_depth = min(raw_history, RAW_HISTORY_MAX);
+		priv->raw_ring = kvcalloc(priv->raw_depth, sizeof(*priv->raw_ring), GFP_KERNEL);
+		if (!priv->raw_ring) {
+			ret = -ENOMEM;
+			goto fail_and_close;
+		}
+	}
+
+	/* Sensor values are only mappable through debugfs */
+	if (IS_ENABLED(CONFIG_DEBUG_FS)) {
+		ret = aqc_alloc_sensors_page(priv);
+		if (ret < 0)
+			goto fail_and_close;
+	}
+
+	priv->ctrl_wq = alloc_ordered_workqueue("%s-ctrl", 0, dev_name(&hdev->dev));
+	if (!priv->ctrl_wq) {
+		ret = -ENOMEM;
+		goto fail_and_close;
+	}
+
+	init_rwsem(&priv->ctrl_lock);
+	mutex_init(&priv->io_mutex);
+	mutex_init(&priv->status_mutex);
+	seqlock_init(&priv->sensor_lock);
+	spin_lock_init(&priv->raw_lock);
+	init_waitqueue_head(&priv->raw_wait);
+	INIT_DELAYED_WORK(&priv->ctrl_write_work, aqc_ctrl_write_work);
+	INIT_DELAYED_WORK(&priv->ctrl_commit_work, aqc_ctrl_commit_work);
+	INIT_DELAYED_WORK(&priv->poll_work, aqc_legacy_poll_work);
+
+	if (priv->info->status_report_id != 0)
+		priv->update_interval = clamp_val(poll_interval, UPDATE_INTERVAL_MIN,
+						  UPDATE_INTERVAL_MAX);
+	else
+		priv->update_interval = PUSH_REPORT_INTERVAL;
 
-	if (priv->kind == aquaero) {
+	if (priv->info->kind == aquaero) {
 		hid_device_io_start(hdev);
 
 		/*
 		 * Wait until the first Aquaero sensor report is received,
 		 * to be able to differentiate between Aquaero 5 and 6
-		 * in aqc_is_visible() by looking at the hardware version.
+		 * in aqc_build_chip_info() by looking at the hardware version.
 		 */
 		if (!wait_for_completion_timeout(&priv->aquaero_sensor_report_received,
 						 STATUS_UPDATE_INTERVAL))
@@ -3269,33 +5361,87 @@ static int aqc_probe(struct hid_device *hdev, const struct hid_device_id *id)
 				 "didn't read aquaero hw version, some functionality won't be available\n");
 	}
 
-	priv->hwmon_dev = hwmon_device_register_with_info(&hdev->dev, priv->name, priv,
-							  &aqc_chip_info, priv->groups);
+	chip_info = aqc_build_chip_info(priv);
+	if (IS_ERR(chip_info)) {
+		ret = (int)PTR_ERR(chip_info);
+		goto fail_and_close;
+	}
+
+	priv->hwmon_dev = hwmon_device_register_with_info(&hdev->dev, priv->info->name, priv,
+							  chip_info, priv->groups);
 	if (IS_ERR(priv->hwmon_dev)) {
 		ret = (int)PTR_ERR(priv->hwmon_dev);
 		goto fail_and_close;
 	}
 
+	/* Missing the node only means that pollers of sequence aren't woken up */
+	WRITE_ONCE(priv->sequence_kn, sysfs_get_dirent(priv->hwmon_dev->kobj.sd, "sequence"));
+
+	/* The IIO device is optional, so the hwmon one is kept if it can't be registered */
+	ret = aqc_iio_register(priv);
+	if (ret < 0)
+		hid_warn(hdev, "couldn't register IIO device: %d\n", ret);
+
+	if (priv->info->status_report_id != 0)
+		schedule_delayed_work(&priv->poll_work, 0);
+
 	aqc_debugfs_init(priv);
 
+	mutex_lock(&aqc_devices_lock);
+	list_add_tail(&priv->node, &aqc_devices);
+	mutex_unlock(&aqc_devices_lock);
+
 	return 0;
 
 fail_and_close:
 	hid_hw_close(hdev);
 fail_and_stop:
 	hid_hw_stop(hdev);
+	if (priv->ctrl_wq)
+		destroy_workqueue(priv->ctrl_wq);
+	kvfree(priv->raw_ring);
+	free_page((unsigned long)priv->sensors_page);
 	return ret;
 }
 
 static void aqc_remove(struct hid_device *hdev)
 {
 	struct aqc_data *priv = hid_get_drvdata(hdev);
+	unsigned long flags;
+
+	mutex_lock(&aqc_devices_lock);
+	list_del(&priv->node);
+	mutex_unlock(&aqc_devices_lock);
+
+	/* Blocked readers of raw_reports would keep debugfs removal waiting */
+	spin_lock_irqsave(&priv->raw_lock, flags);
+	priv->raw_closed = true;
+	spin_unlock_irqrestore(&priv->raw_lock, flags);
+	wake_up_interruptible_all(&priv->raw_wait);
 
 	debugfs_remove_recursive(priv->debugfs);
 	hwmon_device_unregister(priv->hwmon_dev);
 
+	cancel_delayed_work_sync(&priv->poll_work);
+
+	/* Send out deferred writes and save them while the device is still reachable */
+	flush_delayed_work(&priv->ctrl_write_work);
+	flush_delayed_work(&priv->ctrl_commit_work);
+	destroy_workqueue(priv->ctrl_wq);
+
+	/* Without a ctrl_commit_interval, nothing was queued to save volatile writes */
+	mutex_lock(&priv->io_mutex);
+	if (priv->ctrl_unsaved)
+		aqc_ctrl_commit(priv);
+	mutex_unlock(&priv->io_mutex);
+
 	hid_hw_close(hdev);
 	hid_hw_stop(hdev);
+
+	/* No more reports can arrive, so the node isn't used anymore */
+	sysfs_put(priv->sequence_kn);
+	kvfree(priv->raw_ring);
+	free_page((unsigned long)priv->sensors_page);
 }
 
 static const struct hid_device_id aqc_table[] = {
@@ -3326,12 +5472,28 @@ static struct hid_driver aqc_driver = {
 
 static int __init aqc_init(void)
 {
-	return hid_register_driver(&aqc_driver);
+	int ret;
+
+	ret = genl_register_family(&aqc_genl_family);
+	if (ret < 0)
+		return ret;
+
+	aqc_debugfs_register();
+
+	ret = hid_register_driver(&aqc_driver);
+	if (ret < 0) {
+		aqc_debugfs_unregister();
+		genl_unregister_family(&aqc_genl_family);
+	}
+
+	return ret;
 }
 
 static void __exit aqc_exit(void)
 {
 	hid_unregister_driver(&aqc_driver);
+	aqc_debugfs_unregister();
+	genl_unregister_family(&aqc_genl_family);
 }
 
 /* Request to initialize after the HID bus to ensure it's not being loaded before */
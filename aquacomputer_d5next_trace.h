@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Tracepoints for control report transfers of the Aquacomputer hwmon driver
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM aquacomputer_d5next
+
+#if !defined(_AQUACOMPUTER_D5NEXT_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _AQUACOMPUTER_D5NEXT_TRACE_H
+
+#include <generated/uapi/linux/version.h>
+#include <linux/hid.h>
+#include <linux/tracepoint.h>
+
+#ifndef AQC_TRACE_ASSIGN_STR
+#if KERNEL_VERSION(6, 10, 0) <= LINUX_VERSION_CODE
+#define AQC_TRACE_ASSIGN_STR(field, src)	__assign_str(field)
+#else
+#define AQC_TRACE_ASSIGN_STR(field, src)	__assign_str(field, src)
+#endif
+#define AQC_TRACE_ASSIGN_DEV(hdev)	AQC_TRACE_ASSIGN_STR(dev, dev_name(&(hdev)->dev))
+
+/* Count of sensor types, as in enum aqc_sensor_types */
+#define AQC_TRACE_SENSOR_TYPES		8
+#endif
+
+/* Wait before a control report transfer, so that the device can process the previous one */
+TRACE_EVENT(aqc_ctrl_delay,
+	    TP_PROTO(struct hid_device *hdev, unsigned int delay_ms, u64 slept_ns),
+	    TP_ARGS(hdev, delay_ms, slept_ns),
+
+	    TP_STRUCT__entry(__string(dev, dev_name(&hdev->dev))
+			     __field(unsigned int, delay_ms)
+			     __field(u64, slept_ns)
+	    ),
+
+	    TP_fast_assign(AQC_TRACE_ASSIGN_DEV(hdev);
+			   __entry->delay_ms = delay_ms;
+			   __entry->slept_ns = slept_ns;
+	    ),
+
+	    TP_printk("%s delay=%ums slept=%lluns", __get_str(dev), __entry->delay_ms,
+		      __entry->slept_ns)
+);
+
+/* Control report read from the device */
+TRACE_EVENT(aqc_ctrl_get,
+	    TP_PROTO(struct hid_device *hdev, u8 report_id, u16 size, u64 delay_ns,
+		     u64 get_ns, int ret),
+	    TP_ARGS(hdev, report_id, size, delay_ns, get_ns, ret),
+
+	    TP_STRUCT__entry(__string(dev, dev_name(&hdev->dev))
+			     __field(u8, report_id)
+			     __field(u16, size)
+			     __field(u64, delay_ns)
+			     __field(u64, get_ns)
+			     __field(int, ret)
+	    ),
+
+	    TP_fast_assign(AQC_TRACE_ASSIGN_DEV(hdev);
+			   __entry->report_id = report_id;
+			   __entry->size = size;
+			   __entry->delay_ns = delay_ns;
+			   __entry->get_ns = get_ns;
+			   __entry->ret = ret;
+	    ),
+
+	    TP_printk("%s id=0x%02x size=%u delay=%lluns get=%lluns ret=%d", __get_str(dev),
+		      __entry->report_id, __entry->size, __entry->delay_ns, __entry->get_ns,
+		      __entry->ret)
+);
+
+/*
+ * Control report sent to the device, followed by the secondary report that saves it,
+ * unless secondary_size is 0
+ */
+TRACE_EVENT(aqc_ctrl_set,
+	    TP_PROTO(struct hid_device *hdev, u8 report_id, u16 size, u8 secondary_report_id,
+		     u16 secondary_size, u64 delay_ns, u64 set_ns, u64 secondary_ns, int ret),
+	    TP_ARGS(hdev, report_id, size, secondary_report_id, secondary_size, delay_ns, set_ns,
+		    secondary_ns, ret),
+
+	    TP_STRUCT__entry(__string(dev, dev_name(&hdev->dev))
+			     __field(u8, report_id)
+			     __field(u16, size)
+			     __field(u8, secondary_report_id)
+			     __field(u16, secondary_size)
+			     __field(u64, delay_ns)
+			     __field(u64, set_ns)
+			     __field(u64, secondary_ns)
+			     __field(int, ret)
+	    ),
+
+	    TP_fast_assign(AQC_TRACE_ASSIGN_DEV(hdev);
+			   __entry->report_id = report_id;
+			   __entry->size = size;
+			   __entry->secondary_report_id = secondary_report_id;
+			   __entry->secondary_size = secondary_size;
+			   __entry->delay_ns = delay_ns;
+			   __entry->set_ns = set_ns;
+			   __entry->secondary_ns = secondary_ns;
+			   __entry->ret = ret;
+	    ),
+
+	    TP_printk("%s id=0x%02x size=%u secondary_id=0x%02x secondary_size=%u delay=%lluns set=%lluns secondary=%lluns ret=%d",
+		      __get_str(dev), __entry->report_id, __entry->size,
+		      __entry->secondary_report_id, __entry->secondary_size, __entry->delay_ns,
+		      __entry->set_ns, __entry->secondary_ns, __entry->ret)
+);
+
+/* Secondary report sent on its own, saving the settings written in volatile mode */
+TRACE_EVENT(aqc_ctrl_commit,
+	    TP_PROTO(struct hid_device *hdev, u8 report_id, u16 size, u64 delay_ns,
+		     u64 commit_ns, int ret),
+	    TP_ARGS(hdev, report_id, size, delay_ns, commit_ns, ret),
+
+	    TP_STRUCT__entry(__string(dev, dev_name(&hdev->dev))
+			     __field(u8, report_id)
+			     __field(u16, size)
+			     __field(u64, delay_ns)
+			     __field(u64, commit_ns)
+			     __field(int, ret)
+	    ),
+
+	    TP_fast_assign(AQC_TRACE_ASSIGN_DEV(hdev);
+			   __entry->report_id = report_id;
+			   __entry->size = size;
+			   __entry->delay_ns = delay_ns;
+			   __entry->commit_ns = commit_ns;
+			   __entry->ret = ret;
+	    ),
+
+	    TP_printk("%s id=0x%02x size=%u delay=%lluns commit=%lluns ret=%d", __get_str(dev),
+		      __entry->report_id, __entry->size, __entry->delay_ns, __entry->commit_ns,
+		      __entry->ret)
+);
+
+/*
+ * Sensor values parsed from a report, of all types in the order of enum aqc_sensor_types,
+ * with counts holding how many there are of each type
+ */
+TRACE_EVENT(aqc_sensor_report,
+	    TP_PROTO(struct hid_device *hdev, const char *kind, const u32 *serial_number,
+		     unsigned long seq, const u8 *counts, const s32 *values,
+		     unsigned int num_values),
+	    TP_ARGS(hdev, kind, serial_number, seq, counts, values, num_values),
+
+	    TP_STRUCT__entry(__string(dev, dev_name(&hdev->dev))
+			     __string(kind, kind)
+			     __array(u32, serial_number, 2)
+			     __field(unsigned long, seq)
+			     __array(u8, counts, AQC_TRACE_SENSOR_TYPES)
+			     __dynamic_array(s32, values, num_values)
+	    ),
+
+	    TP_fast_assign(AQC_TRACE_ASSIGN_DEV(hdev);
+			   AQC_TRACE_ASSIGN_STR(kind, kind);
+			   memcpy(__entry->serial_number, serial_number,
+				  sizeof(__entry->serial_number));
+			   __entry->seq = seq;
+			   memcpy(__entry->counts, counts, sizeof(__entry->counts));
+			   memcpy(__get_dynamic_array(values), values, num_values * sizeof(s32));
+	    ),
+
+	    TP_printk("%s %s %05u-%05u seq=%lu counts=%s values=%s", __get_str(dev),
+		      __get_str(kind), __entry->serial_number[0], __entry->serial_number[1],
+		      __entry->seq,
+		      __print_array(__entry->counts, AQC_TRACE_SENSOR_TYPES, sizeof(u8)),
+		      __print_array(__get_dynamic_array(values),
+				    __get_dynamic_array_len(values) / sizeof(s32), sizeof(s32)))
+);
+
+#endif /* _AQUACOMPUTER_D5NEXT_TRACE_H */
+
+/* The header is in the module source directory, which Kbuild adds to the include path */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE aquacomputer_d5next_trace
+#include <trace/define_trace.h>